@@ -0,0 +1,111 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#include <rcube.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// random moves taken from the given faces
+std::vector<rcube::Move> randomMoves(const std::vector<MoveFace> &faces, int n)
+{
+  std::vector<rcube::Move> res;
+  for (int i = 0; i < n; ++i)
+  {
+    MoveFace face = faces[rand() % faces.size()];
+    const MoveDirection dirs[3] = {CW, CCW, DOUBLE};
+    res.push_back(rcube::Move(face, dirs[rand() % 3]));
+  }
+  return res;
+}
+
+// run f once for each move and print the number of moves per second (f
+// applies each move to the given number of cubes)
+template <typename F>
+void bench(const std::string &name, const std::vector<rcube::Move> &moves,
+  int rounds, F f, int cubes = 1)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r)
+  {
+    for (const rcube::Move &mv: moves) f(mv);
+  }
+  std::chrono::duration<double> secs = std::chrono::steady_clock::now() -
+    start;
+
+  double total = (double)moves.size() * rounds * cubes;
+  std::cout << name << ": " << (long long)(total / secs.count()) <<
+    " moves/s\n";
+}
+
+#ifdef BENCH_BASELINE
+
+// Built against the sources of the baseline commit (see STATS.md), where
+// Cube::performMove rotates the stickers of each block with rotateLayer: only
+// the functions that already existed there are measured
+void benchSet(const std::string &name, const std::vector<MoveFace> &faces)
+{
+  std::vector<rcube::Move> moves = randomMoves(faces, 10000);
+
+  std::cout << name << "\n";
+
+  rcube::Cube cube;
+  bench("  Cube::performMove (rotateLayer)", moves, 5,
+    [&](const rcube::Move &mv) { cube.performMove(mv); });
+
+  std::cout << "  (" << cube.isSolved() << ")\n";
+}
+
+#else
+
+void benchSet(const std::string &name, const std::vector<MoveFace> &faces)
+{
+  std::vector<rcube::Move> moves = randomMoves(faces, 10000);
+
+  std::cout << name << "\n";
+
+  rcube::PackedState state;
+  bench("  PackedState::performMove", moves, 1000,
+    [&](const rcube::Move &mv) { state.performMove(mv); });
+
+  rcube::Cube cube;
+  bench("  Cube::performMove", moves, 100,
+    [&](const rcube::Move &mv) { cube.performMove(mv); });
+
+  // reading a sticker after every move forces the block view to be rebuilt,
+  // which is the same amount of work the old sticker-based rotation did
+  rcube::Cube cube1;
+  bench("  Cube::performMove + getStickerAt", moves, 20,
+    [&](const rcube::Move &mv) {
+      cube1.performMove(mv);
+      cube1.getStickerAt({1, 1, 1}, {Axis::Y, 1});
+    });
+
+  rcube::CubeBatch batch(4096);
+  bench("  CubeBatch::performMove", moves, 1,
+    [&](const rcube::Move &mv) { batch.performMove(mv); }, batch.size());
+
+  // keep the results alive
+  std::cout << "  (" << (int)state.data[0] << cube.isSolved() <<
+    cube1.isSolved() << batch.countSolved() << ")\n";
+}
+
+#endif
+
+int main()
+{
+  srand(0);
+
+  benchSet("Face moves", {RIGHT, LEFT, UP, DOWN, FRONT, BACK});
+  benchSet("Slices, wide moves and rotations", {MIDDLE, EQUATOR, SIDE,
+    RIGHT_W, LEFT_W, UP_W, DOWN_W, FRONT_W, BACK_W, ROTATE_X, ROTATE_Y,
+    ROTATE_Z});
+}
@@ -10,6 +10,9 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstdint>
+#include <functional>
 
 #include <utility.hpp>
 
@@ -19,6 +22,7 @@
 namespace rcube
 {
     struct Coordinates;
+    struct PackedState;
 
     struct Orientation
     {
@@ -336,9 +340,112 @@ namespace rcube
         * Returns a move applied to the same face but with opposite direction.
         */
 
-	    MoveFace face; // the kind of move to perform
-        MoveDirection direction; // the direction of the rotation
-        Axis axis; // the rotation axis
+        bool operator==(const rcube::Move &m) const;
+        bool operator!=(const rcube::Move &m) const;
+        /*
+        * Two moves are equal when they have the same face and direction.
+        */
+
+	    MoveFace face : 8; // the kind of move to perform
+        MoveDirection direction : 8; // the direction of the rotation
+        Axis axis : 8; // the rotation axis
+        // each field is stored in a single byte, while the enums keep their
+        // int-like type (so they are still printed as numbers)
+    };
+
+    class MoveVector {
+        /*
+        * A std::vector-like container of rcube::Move that stores up to
+        * INLINE_SIZE moves inside the object itself and only allocates memory
+        * on the heap for longer sequences. It is used by rcube::Algorithm, so
+        * most algorithms never allocate.
+        */
+
+    public:
+        static const int INLINE_SIZE = 32;
+
+        typedef rcube::Move value_type;
+        typedef rcube::Move* iterator;
+        typedef const rcube::Move* const_iterator;
+        typedef std::size_t size_type;
+
+        MoveVector();
+        MoveVector(const std::vector<rcube::Move> &moves);
+        MoveVector(const rcube::MoveVector &v);
+        MoveVector(rcube::MoveVector &&v) noexcept;
+        ~MoveVector();
+
+        rcube::MoveVector& operator=(const rcube::MoveVector &v);
+        rcube::MoveVector& operator=(rcube::MoveVector &&v) noexcept;
+
+        operator std::vector<rcube::Move>() const;
+        // conversion kept for compatibility with the former std::vector
+
+        inline size_type size() const { return count; }
+        inline bool empty() const { return count == 0; }
+        inline size_type capacity() const { return cap; }
+
+        inline rcube::Move* data() { return ptr; }
+        inline const rcube::Move* data() const { return ptr; }
+
+        inline iterator begin() { return ptr; }
+        inline iterator end() { return ptr + count; }
+        inline const_iterator begin() const { return ptr; }
+        inline const_iterator end() const { return ptr + count; }
+
+        inline rcube::Move& operator[](size_type i) { return ptr[i]; }
+        inline const rcube::Move& operator[](size_type i) const
+            { return ptr[i]; }
+
+        inline rcube::Move& front() { return ptr[0]; }
+        inline const rcube::Move& front() const { return ptr[0]; }
+        inline rcube::Move& back() { return ptr[count - 1]; }
+        inline const rcube::Move& back() const { return ptr[count - 1]; }
+
+        inline void push_back(const rcube::Move &m)
+        {
+            if (count == cap)
+            {
+                rcube::Move copy = m; // m may point inside this vector
+                reserve(cap * 2);
+                ptr[count++] = copy;
+                return;
+            }
+            ptr[count++] = m;
+        }
+
+        inline void pop_back() { count--; }
+        inline void clear() { count = 0; }
+
+        void reserve(size_type n);
+        /*
+        * Makes room for at least n moves.
+        */
+
+        iterator insert(const_iterator pos, const rcube::Move &m);
+        iterator insert(const_iterator pos, const_iterator first,
+            const_iterator last);
+        /*
+        * Inserts a move or a range of moves before pos.
+        */
+
+        iterator erase(const_iterator pos);
+        iterator erase(const_iterator first, const_iterator last);
+        /*
+        * Removes a move or a range of moves.
+        */
+
+        bool operator==(const rcube::MoveVector &v) const;
+        bool operator!=(const rcube::MoveVector &v) const;
+
+    private:
+        rcube::Move *ptr; // points to buffer or to the heap
+        size_type count;
+        size_type cap;
+
+        alignas(rcube::Move) unsigned char buffer[INLINE_SIZE *
+            sizeof(rcube::Move)];
+        // inline storage (rcube::Move has no default constructor)
     };
 
     class Algorithm {
@@ -356,7 +463,19 @@ namespace rcube
         * allowed (they will be ignored).
         * 
         * NOTE: this constructor may throw a std::invalid_argument exception
-        * if the string contains an invalid character.
+        * if the string contains an invalid character (the message contains
+        * its position).
+        */
+
+        static int parse(std::string_view str, rcube::MoveVector *dest);
+        /*
+        * Appends the moves of a string in the default notation to dest, in a
+        * single pass and without allocating memory as long as dest has enough
+        * capacity. Macros like "$(sune)" are replaced by the algorithms of the
+        * database, which are parsed once and stored in a hash table.
+        * Returns -1 on success, otherwise the position of the first invalid
+        * character (or of the '$' of an unknown macro). In this case dest
+        * contains the moves that precede it.
         */
 
         Algorithm (const std::vector<rcube::Move>& fromVector);
@@ -366,32 +485,107 @@ namespace rcube
 
         ~Algorithm() = default;
 
-        rcube::Algorithm operator*(const int& factor);
+        Algorithm(const rcube::Algorithm &a) = default;
+        Algorithm(rcube::Algorithm &&a) noexcept = default;
+        rcube::Algorithm& operator=(const rcube::Algorithm &a) = default;
+        rcube::Algorithm& operator=(rcube::Algorithm &&a) noexcept = default;
+        /*
+        * The declared destructor would otherwise suppress the moves. They
+        * never throw, so containers of algorithms move them when they grow.
+        */
+
+        rcube::Algorithm operator*(const int& factor) const &;
+        rcube::Algorithm operator*(const int& factor) &&;
         /*
         * Multiplies the algorithm by a factor. The algorithm is NOT repeated
         * factor times, but all the directions of the moves are multiplied by it.
+        * Moves whose direction becomes 0 are removed. When called on a
+        * temporary, the moves are modified in place instead of being copied.
         * NOTE: only designed and tested for factor = {-1, 1, 2}
         */
 
-       rcube::Algorithm operator+(const rcube::Algorithm a);
+        rcube::Algorithm operator+(const rcube::Algorithm &a) const &;
+        rcube::Algorithm operator+(const rcube::Algorithm &a) &&;
         /*
-        * Concatenates two algorithms
+        * Concatenates two algorithms. When the left operand is a temporary
+        * (e.g. "a + b + c"), its moves are reused instead of being copied.
         */
 
-       inline void push(const rcube::Move &m);
+        rcube::Algorithm& operator+=(const rcube::Algorithm &a);
+        rcube::Algorithm& append(const rcube::Algorithm &a);
+        /*
+        * Appends the moves of a to the algorithm. Building a long algorithm
+        * this way takes linear time (algo += x instead of algo = algo + x).
+        */
+
+       inline void push(const rcube::Move &m) { algorithm.push_back(m); }
         /*
         * Appends a rcube::Move to the algorithm
         */
 
+        inline void reserve(int n) { algorithm.reserve(n); }
+        /*
+        * Makes room for n moves, so that appending up to n moves does not
+        * allocate memory.
+        */
+
        static rcube::Algorithm generateScramble(const int &length = 12);
        /*
-       * Generates a random algorithm of given length (default=12)
+       * Generates a random algorithm of given length (default=12), without
+       * consecutive moves of the same face
        */
 
+        static rcube::Algorithm generateRandomStateScramble();
+        /*
+        * Picks a state of the cube uniformly at random among the solvable ones
+        * and returns an algorithm (about 20-25 moves long) that takes a solved
+        * cube to it, found with the Kociemba solver.
+        * NOTE: the Kociemba lookup tables are loaded (or generated) first
+        */
+
+        static std::vector<rcube::Algorithm> generateRandomStateScrambles(
+            int count, int threads = 1);
+        /*
+        * Generates count random state scrambles, solving the states in the
+        * given number of threads. The result only depends on the seed of the
+        * calling thread (see seedScrambles), not on the number of threads.
+        */
+
+        static void seedScrambles(uint64_t seed);
+        /*
+        * Each thread generates scrambles with its own random generator, seeded
+        * randomly when first used. This sets the seed of the calling thread's
+        * generator, to get reproducible scrambles.
+        */
+
         void normalize();
         /*
         * Rewrites the algorithm by:
         * - merging consecutive moves of the same layer (UU → U2)
+        * - merging moves of the same axis, which commute (RLR' → L)
+        * - rewriting each run of moves along an axis with as few moves as
+        *   possible, in a fixed order (RM'L' → L'r)
+        * Rotations are only used if the algorithm already contains some.
+        */
+
+        void optimize(int threads = 1, int timeout = 1000);
+        /*
+        * Shortens the algorithm by local search: every window of up to 8
+        * consecutive R, L, U, D, F and B moves is replaced by an optimal
+        * sequence that has the same effect, found in a precomputed table of
+        * the sequences of up to 4 moves (longer ones are split in two halves).
+        * Other moves (slices, wide moves and rotations) are left untouched.
+        * The search is repeated until no window can be shortened.
+        * @param threads: number of threads the windows are split among
+        * @param timeout: time budget in milliseconds, after which the windows
+        * that have not been evaluated yet are left as they are
+        * NOTE: the table (about 47000 states) is built by the first call
+        */
+
+        rcube::Algorithm optimized(int threads = 1, int timeout = 1000) const;
+        /*
+        * Same as optimize but the result is returned instead of being applied
+        * to the current instance.
         */
 
         rcube::Algorithm reverse() const;
@@ -400,6 +594,52 @@ namespace rcube
         * and changing the moves' directions.
         */
 
+        class ReverseView {
+            /*
+            * A range over the moves of reverse() that reads them from the
+            * original algorithm on the fly, without copying them. It is only
+            * valid as long as the algorithm is alive and unchanged.
+            */
+
+        public:
+            class iterator {
+            public:
+                iterator(const rcube::Move *pos) : pos(pos) {}
+
+                inline rcube::Move operator*() const
+                {
+                    rcube::Move m = *(pos - 1);
+                    if (abs(m.direction) == 1)
+                        m.direction = (MoveDirection)-m.direction;
+                    return m;
+                }
+
+                inline iterator& operator++() { --pos; return *this; }
+                inline bool operator==(const iterator &it) const
+                    { return pos == it.pos; }
+                inline bool operator!=(const iterator &it) const
+                    { return pos != it.pos; }
+
+            private:
+                const rcube::Move *pos; // one past the current move
+            };
+
+            ReverseView(const rcube::Algorithm &algo) : algo(algo) {}
+
+            inline iterator begin() const { return algo.algorithm.end(); }
+            inline iterator end() const { return algo.algorithm.begin(); }
+            inline int length() const { return algo.length(); }
+
+        private:
+            const rcube::Algorithm &algo;
+        };
+
+        inline ReverseView reversed() const { return ReverseView(*this); }
+        /*
+        * Same as reverse(), but returns a view to iterate over instead of a
+        * new algorithm (e.g. "for (rcube::Move m : algo.reversed())").
+        */
+
         rcube::Algorithm withoutRotations() const;
         /*
         * Returns an algorithm equivalent to the current instance but without
@@ -418,13 +658,206 @@ namespace rcube
         * (e.g. "RUR'U'").
         */
 
-       inline int length() const;
+        rcube::PackedState compile() const;
+        /*
+        * Returns the state obtained by applying the algorithm to a solved cube.
+        * Multiplying any state by it is the same as applying the algorithm
+        * (see rcube::PackedState::multiply), but costs a single move.
+        */
+
+        int getOrder() const;
+        /*
+        * Returns the number of times the algorithm has to be repeated to get
+        * back to the initial state (e.g. 6 for "RUR'U'").
+        */
+
+       inline int length() const { return algorithm.size(); }
        /*
        * Returns the length of the algorithm (number of moves).
        */
 
-        std::vector<rcube::Move> algorithm;
-        // the algorithm is stored as a std::vector of rcube::Move
+        bool operator==(const rcube::Algorithm &a) const;
+        bool operator!=(const rcube::Algorithm &a) const;
+        /*
+        * Two algorithms are equal when they contain the same moves in the same
+        * order (no simplification is performed, so "R2" != "RR").
+        */
+
+        uint64_t getHash() const;
+        /*
+        * Returns a 64-bit hash of the sequence of moves (also available through
+        * std::hash<rcube::Algorithm>).
+        */
+
+        rcube::MoveVector algorithm;
+        // the algorithm is stored as a rcube::MoveVector (a std::vector-like
+        // container that does not allocate for up to 32 moves)
+    };
+
+    struct PackedState
+    {
+        /*
+        * This struct stores the state of the cube in 32 bytes. Each byte
+        * describes a slot (the place of an edge, corner or center in the 3D
+        * space): the 4 lower bits contain the index of the piece sitting in
+        * the slot, the 2 bits above contain the piece's orientation.
+        * The slots and the orientations follow the same conventions as the
+        * Kociemba solver (see src/kociemba/cubieCube.hpp), the centers are
+        * numbered like rcube::Orientation::iterate(). Piece indices are relative
+        * to the 16-byte half they belong to, so the centers are stored as 8 +
+        * the index of their face.
+        *
+        * With this layout, every move is itself a PackedState (the state
+        * obtained by applying the move to a solved cube) and applying it is a
+        * byte permutation followed by an addition of the orientations. This
+        * is done with SSSE3/AVX2 byte shuffles when the compiler supports
+        * them, with a plain loop otherwise.
+        */
+
+        static const int EDGES = 0;    // 12 edges (+4 unused bytes)
+        static const int CORNERS = 16; // 8 corners
+        static const int CENTERS = 24; // 6 centers (+2 unused bytes)
+
+        PackedState();
+        /*
+        * Initializes a solved state (every piece in its own slot)
+        */
+
+        uint8_t data[32];
+
+        void multiply(const rcube::PackedState &t);
+        /*
+        * Permutes and orients the pieces as t would do to a solved cube. This
+        * means applying to the current state all the moves that were used to
+        * get to t.
+        */
+
+        void performMove(const rcube::Move &move);
+        /*
+        * Applies a rcube::Move (any layer, slice, wide move or rotation)
+        */
+
+        void performAlgorithm(const rcube::Algorithm &algo);
+        /*
+        * Applies every move of a rcube::Algorithm
+        */
+
+        rcube::PackedState operator*(const rcube::PackedState &t) const;
+        /*
+        * Returns a copy of the current state multiplied by t. If both states
+        * are compiled algorithms (see rcube::Algorithm::compile), the result
+        * is the compiled concatenation of the two.
+        */
+
+        rcube::PackedState getInverse() const;
+        /*
+        * Returns the state t such that multiplying the current state by t gives
+        * a solved state.
+        */
+
+        int getOrder() const;
+        /*
+        * Returns the number of times the state has to be multiplied by itself
+        * to get back to a solved state (e.g. 6 for the state of RUR'U').
+        */
+
+        std::vector<std::vector<int>> getCycles() const;
+        /*
+        * Returns the cycles of the permutation: each cycle is the list of the
+        * slots (indices of data) whose pieces move into each other, in order.
+        * Pieces that stay in their slot are only listed when they are twisted
+        * or flipped.
+        */
+
+        rcube::PackedState getReoriented() const;
+        /*
+        * Returns the same state with the pieces renamed relatively to the
+        * current position of the centers (the centers end up in their own
+        * slots). This is how the Kociemba solver sees the cube after rotations
+        * (x, y, z) have been applied.
+        */
+
+        static const rcube::PackedState& getMoveState(const rcube::Move &move);
+        /*
+        * Returns the precomputed state of a move applied to a solved cube.
+        *
+        * NOTE: this function may throw a std::invalid_argument exception if
+        * the move is not supported.
+        */
+
+        static const rcube::Orientation edgeFaces[12][2];
+        static const rcube::Orientation cornerFaces[8][3];
+        /*
+        * The faces each slot is adjacent to. The first face is the reference
+        * one for orientations, the others follow clockwise.
+        */
+
+        static int faceIndex(const rcube::Orientation &face);
+        /*
+        * Returns the index of a face in rcube::Orientation::iterate()
+        */
+
+        bool isSolved() const;
+        /*
+        * Returns true when every piece is in its slot relatively to the
+        * current position of the centers.
+        */
+
+        bool operator==(const rcube::PackedState &t) const;
+        bool operator!=(const rcube::PackedState &t) const;
+
+        uint64_t getHash() const;
+        /*
+        * Returns the Zobrist hash of the state: the XOR of a random 64-bit key
+        * for each (slot, byte value) pair.
+        */
+
+        uint64_t getHash(uint32_t slots) const;
+        /*
+        * Returns the XOR of the keys of the given slots only (bit i of slots
+        * = byte i of data). Since a move only changes a few slots, the hash of
+        * the state can be updated by XORing the keys of those slots before
+        * and after the move (see getMovedSlots).
+        */
+
+        static uint32_t getMovedSlots(const rcube::Move &move);
+        /*
+        * Returns the slots changed by a move, in the format used by getHash
+        * (0 if the move is not supported).
+        */
+    };
+
+    struct SymmetryKey
+    {
+        /*
+        * The canonical representative of a cube under the 48 symmetries of
+        * the cube (24 rotations, each optionally mirrored) and, optionally,
+        * inversion. Cubes that are equivalent under these transformations get
+        * the same key, so a solution computed for one of them can be reused
+        * for all the others through mapSolution.
+        */
+
+        rcube::PackedState state;
+        // the representative (the lowest state, compared byte by byte, with
+        // the centers in their slots)
+
+        uint64_t key;
+        // state.getHash()
+
+        int symmetry;
+        // the symmetry S (0 to 47) such that state = S * cube * S^-1
+
+        bool inverse;
+        // true if state was obtained from the inverse of the cube
+
+        rcube::Algorithm mapSolution(const rcube::Algorithm &solution) const;
+        /*
+        * Converts an algorithm that solves state into one that solves the
+        * original cube.
+        *
+        * NOTE: this function may throw a std::invalid_argument exception if
+        * the algorithm contains moves other than R, L, U, D, F and B.
+        */
     };
 
     class Cube {
@@ -459,7 +892,7 @@ namespace rcube
 
         void performMove (const rcube::Move& move);
         /*
-         * Applies a rcube::Move
+         * Applies a rcube::Move. Moves on unknown faces are ignored.
         */
 
         void performAlgorithm (const rcube::Algorithm& algorithm);
@@ -472,6 +905,12 @@ namespace rcube
         * Shortcut for performAlgorithm(rcube::Algorithm("string"))
         */
 
+        void performAlgorithm (const rcube::PackedState &compiled);
+        /*
+        * Applies an algorithm compiled with rcube::Algorithm::compile(), at the
+        * cost of a single move.
+        */
+
         void scramble(const int &length = 12, rcube::Algorithm* dest = nullptr);
         /*
          * Performs a randomly generated algorithm.
@@ -663,6 +1102,14 @@ namespace rcube
         * @return: the algorithm used to solve the cube
         */
 
+        rcube::Algorithm solveCfopColorNeutral(bool verbose = false);
+        /*
+        * Solves the cube using the cfop algorithm starting from each of the 6
+        * cross colors in parallel and keeps the shortest solution.
+        * @param verbose: enable output to stdout
+        * @return: the algorithm used to solve the cube
+        */
+
         rcube::Algorithm solveKociemba();
         /*
         * Solves the cube using the Kociemba algorithm (see include/solving.hpp)
@@ -679,19 +1126,53 @@ namespace rcube
         * @return: the shortest solution found
         */
 
+        const rcube::PackedState& getState() const;
+        /*
+        * Returns the internal state of the cube (see rcube::PackedState).
+        */
+
+        uint64_t getHash() const;
+        /*
+        * Returns a 64-bit hash of the state of the cube, updated at every move
+        * (also available through std::hash<rcube::Cube>).
+        */
+
+        bool operator==(const rcube::Cube &c) const;
+        bool operator!=(const rcube::Cube &c) const;
+        /*
+        * Two cubes are equal when they show the same colors on each face.
+        */
+
+        rcube::SymmetryKey getSymmetryKey(bool useInverse = false) const;
+        /*
+        * Returns the canonical representative of the cube under the 48
+        * symmetries (see rcube::SymmetryKey). The rotations of the whole cube
+        * that have been performed are ignored.
+        * @param useInverse: also consider the symmetries of the inverse of the
+        * cube
+        */
+
 
     private:
-        // internally, the cube is abstracted as an array of 6 rcube::Center, 12
-        // rcube::Edge and 8 rcube::Corner
+        // internally, the moves are applied to a rcube::PackedState
+        rcube::PackedState state;
+        uint64_t hash = 0; // state.getHash()
+
+        // the state is expanded into an array of 6 rcube::Center, 12
+        // rcube::Edge and 8 rcube::Corner (indexed by piece) only when it needs
+        // to be read
         rcube::Center centers[6];
         rcube::Edge edges[12];
         rcube::Corner corners[8];
+        bool blocksOutdated = false;
 
-        void changeViewpoint (const rcube::Move& move);
-        // handle the moves x, y and z
+        void updateBlocks();
+        // rebuild centers, edges and corners from state if a move has been
+        // applied since the last call
 
-        void rotateLayer (const rcube::Move& move);
-        // handle the moves R, L, U, D, F, B
+        void packBlocks();
+        // compute state and hash from centers, edges and corners (used when the
+        // cube is initialized from its stickers)
 
         rcube::Center* getCenterFrom(const Color &color);
         // get a pointer to the <color> center
@@ -702,6 +1183,120 @@ namespace rcube
         rcube::Center* getCenterFrom(const rcube::Orientation &orient);
         // get a pointer to the center placed at <coords>
     };
+
+    class CubeBatch {
+        /*
+        * This class stores the states of many cubes and applies the same
+        * moves to all of them. The states are stored as a structure of arrays:
+        * for each slot of rcube::PackedState there is a row with the bytes of
+        * all the cubes, so a move only has to copy whole rows to their new
+        * slots and add the orientations, which is done 16/32 cubes at a time
+        * with SSSE3/AVX2 (or with plain loops otherwise).
+        */
+
+    public:
+        CubeBatch(int size = 0);
+        /*
+        * Initializes size solved cubes.
+        */
+
+        ~CubeBatch() = default;
+
+        int size() const;
+        /*
+        * Returns the number of cubes in the batch.
+        */
+
+        void push(const rcube::PackedState &state);
+        void push(const rcube::Cube &cube);
+        /*
+        * Appends a cube to the batch.
+        */
+
+        rcube::PackedState get(int idx) const;
+        void set(int idx, const rcube::PackedState &state);
+        /*
+        * Read or overwrite the state of the idx-th cube.
+        */
+
+        void multiply(const rcube::PackedState &t);
+        /*
+        * Applies t to all the cubes (see rcube::PackedState::multiply).
+        */
+
+        void performMove(const rcube::Move &move);
+        /*
+        * Applies a rcube::Move to all the cubes.
+        */
+
+        void performAlgorithm(const rcube::Algorithm &algo);
+        /*
+        * Applies a rcube::Algorithm to all the cubes. The moves are first
+        * combined into a single state, so the whole algorithm costs as much
+        * as one move.
+        */
+
+        void performAlgorithm(const std::string &algo);
+        /*
+        * Shortcut for performAlgorithm(rcube::Algorithm("string"))
+        */
+
+        std::vector<bool> isSolved() const;
+        /*
+        * Returns, for each cube, whether it is solved.
+        */
+
+        int countSolved() const;
+        /*
+        * Returns the number of solved cubes.
+        */
+
+        std::vector<uint16_t> getTwist() const;
+        std::vector<uint16_t> getFlip() const;
+        std::vector<uint16_t> getSlice() const;
+        /*
+        * Return, for each cube, the coordinates used by the Kociemba solver:
+        * the orientations of the corners (twist, 0 to 2186), the orientations
+        * of the edges (flip, 0 to 2047) and the positions of the FR, FL, BL
+        * and BR edges (slice, 0 to 494). The coordinates are computed in the
+        * fixed frame of the slots, so the rotations of the whole cube should
+        * be avoided.
+        */
+
+    private:
+        int n; // number of cubes
+        int capacity; // length of each row (a multiple of 32)
+
+        std::vector<uint8_t> data;
+        // data[slot * capacity + i] = data[slot] of the i-th cube
+
+        std::vector<uint8_t> tmp;
+        // buffer used while applying moves
+
+        void reserve(int size);
+        // make room for at least size cubes
+    };
+};
+
+namespace std
+{
+    template<>
+    struct hash<rcube::Cube>
+    {
+        size_t operator()(const rcube::Cube &cube) const
+        {
+            return cube.getHash();
+        }
+    };
+
+    template<>
+    struct hash<rcube::Algorithm>
+    {
+        size_t operator()(const rcube::Algorithm &algo) const
+        {
+            return algo.getHash();
+        }
+    };
 };
 
 #endif
@@ -7,13 +7,27 @@
 * not, see: <https://mit-license.org>.
 */
 
+#include <atomic>
+#include <string>
+
 #include <rcube.hpp>
 #include <utility.hpp>
 
 /*
-* This algorithm solves the cube as a human would do. Therefore it does not
-* require a lot of computations and runs almost instantly but it is by no
-* means optimal as it uses a big number of moves.
+* This algorithm solves the cube as a human would do, one stage at a time:
+* - cross: the shortest cross is found with an IDA* search, guided by the
+*   exact number of moves every cross state needs (crossPrun)
+* - F2L: the pairs are inserted one at a time, always choosing the one that
+*   takes the fewest moves. Each insertion is the shortest one that keeps the
+*   cross and the pairs inserted before in place, found with an IDA* search
+*   guided by crossPrun and pairPrun
+* - OLL and PLL: the case is looked up in an index of the algorithms of the
+*   database (or the whole last layer in a table, see loadLastLayerTable)
+* The tables are generated in memory the first time, then the cube is solved
+* almost instantly, but the solution is by no means optimal as it uses a big
+* number of moves. Two modes, described below, change this: solveColorNeutral
+* (shorter solutions, 6 times the work) and useZbls (the last layer edges are
+* oriented during F2L).
 */
 
 class CfopSolver
@@ -29,10 +43,46 @@ public:
 
     rcube::Algorithm solve();
 
+    // Color neutral mode: the cube is solved starting from each of the 6
+    // colors (the cross color passed to the constructor is ignored) on
+    // separate threads and the shortest solution is returned
+    rcube::Algorithm solveColorNeutral();
+
+    // ZBLS mode: the last F2L pair is inserted in a way that also orients the
+    // edges of the last layer (a few more moves, but the last layer is then
+    // solved with COLL/ZBLL, see loadLastLayerTable)
+    void useZbls(bool enable = true);
+
+    // One-look last layer mode: once a table has been loaded, oll() solves the
+    // whole last layer with a single algorithm when its state is in the table
+    // (and pll() has nothing left to do). Returns false if the file cannot be
+    // read. A table can be loaded while other threads are solving cubes (each
+    // lookup uses the table loaded at that time).
+    static bool loadLastLayerTable(const std::string &path);
+
+    // Writes a table for loadLastLayerTable: every last layer state (or only
+    // the ones with the edges oriented, for ZBLL) is solved with a
+    // KociembaSolver in slow mode, with the given threads and timeout. This
+    // takes a few minutes (ZBLL) to about an hour (all the states).
+    static void generateLastLayerTable(const std::string &path,
+        bool edgesOriented = true, int threads = 16, int timeout = 1);
+
 private:
     rcube::Cube _cube;
     bool _verbose;
     Color _crossColor;
+    bool _zbls = false;
+
+    // Inserts the F2L pair that takes the fewest moves and appends them to
+    // algo. Returns false if the 4 pairs are already solved
+    bool insertPair(rcube::Algorithm *algo);
+
+    // Runs the 4 stages and appends their moves to algo, which is then
+    // normalized and stripped of its rotations. If best is not null, it holds
+    // the best solution found so far (as length * 8 + rank): the function
+    // returns false as soon as algo can no longer beat it, and otherwise
+    // updates it
+    bool solveStages(rcube::Algorithm *algo, std::atomic<int> *best, int rank);
 };
 
 /*
@@ -60,6 +110,9 @@ public:
     // reduce performances
     void useRobotMode(const rcube::Orientation &face);
 
+    // The final solution is printed unless verbose is set to false
+    void setVerbose(bool verbose);
+
     rcube::Algorithm solve();
 
 private:
@@ -68,4 +121,5 @@ private:
     int _timeout;
     int _threads;
     int _robotFace = -1;
+    bool _verbose = true;
 };
\ No newline at end of file
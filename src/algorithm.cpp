@@ -10,16 +10,30 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
 
 #include <rcube.hpp>
 #include <utility.hpp>
 #include "./cfop/algoList.hpp"
 
-rcube::Algorithm::Algorithm(const std::string& fromString)
+// The algorithms of the database, already parsed and indexed by name. A
+// macro can refer to the algorithms that precede it in algoDb.
+struct MacroTable
 {
-  for (int i = 0; i < fromString.length(); ++i) {
+  std::unordered_map<std::string_view, rcube::MoveVector> algos;
+
+  MacroTable();
+};
 
-    switch (fromString[i]) {
+static int parseMoves(std::string_view str, rcube::MoveVector *dest,
+  const std::unordered_map<std::string_view, rcube::MoveVector> &macros)
+{
+  for (size_t i = 0; i < str.size(); ++i)
+  {
+    switch (str[i])
+    {
       case UP:
       case FRONT:
       case RIGHT:
@@ -42,22 +56,15 @@ rcube::Algorithm::Algorithm(const std::string& fromString)
       case ROTATE_Y:
       case ROTATE_Z:
       {
-        switch (fromString[i+1])
-        {
-          case '\'':
-            push(Move(fromString[i], CCW));
-            ++i;
-            break;
-
-          case '2':
-            push(Move(fromString[i], DOUBLE));
-            ++i;
-            break;
-
-          default:
-            push(Move(fromString[i], CW));
-            break;
-        }
+        char face = str[i];
+        char next = i + 1 < str.size() ? str[i + 1] : '\0';
+        int direction = CW;
+
+        if (next == '\'') direction = CCW;
+        if (next == '2') direction = DOUBLE;
+        if (direction != CW) ++i;
+
+        dest->push_back(rcube::Move(face, direction));
         break;
       }
 
@@ -67,133 +74,284 @@ rcube::Algorithm::Algorithm(const std::string& fromString)
       case '[':
       case ']':
       case '\t':
-      {
         break;
-      }
 
       case '$':
       {
-        if (fromString[i+1] != '(')
-        {
-          throw std::invalid_argument("Invalid algorithm");
-        }
-
-        i += 2;
-        std::stringstream ss;
-
-        while (i < fromString.length() && fromString[i] != ')')
-        {
-          ss << fromString[i];
-          i++;
-        }
-
-        bool found = false;
-        for (AlgoDBItem item : algoDb)
-        {
-          if (item.name != ss.str()) continue;
+        size_t end = str.find(')', i);
+        if (i + 1 >= str.size() || str[i + 1] != '(' || end == str.npos)
+          return i;
 
-          found = true;
-          std::vector<rcube::Move> algo = rcube::Algorithm(item.algo).algorithm;
-          algorithm.insert(algorithm.end(), algo.begin(), algo.end());
-          break;
-        }
-        if (!found)
-        {
-          throw std::invalid_argument("Cannot find algorithm: " + ss.str());
-        }
+        auto it = macros.find(str.substr(i + 2, end - i - 2));
+        if (it == macros.end()) return i;
 
-        i++;
+        dest->insert(dest->end(), it->second.begin(), it->second.end());
+        i = end;
         break;
       }
 
       default:
-      {
-        throw std::invalid_argument("Invalid algorithm");
-      }
-     }
-   }
- }
+        return i;
+    }
+  }
+  return -1;
+}
+
+MacroTable::MacroTable()
+{
+  algos.reserve(algoDb.size());
+
+  for (const AlgoDBItem &item : algoDb)
+  {
+    if (algos.count(item.name)) continue;
+
+    rcube::MoveVector moves;
+    if (parseMoves(item.algo, &moves, algos) != -1) continue;
+
+    algos.emplace(item.name, std::move(moves));
+  }
+}
+
+static const MacroTable& getMacroTable()
+{
+  static const MacroTable table;
+  return table;
+}
+
+int rcube::Algorithm::parse(std::string_view str, rcube::MoveVector *dest)
+{
+  return parseMoves(str, dest, getMacroTable().algos);
+}
+
+rcube::Algorithm::Algorithm(const std::string& fromString)
+{
+  int pos = parse(fromString, &algorithm);
+  if (pos == -1) return;
+
+  size_t end = fromString.find(')', pos);
+  if (fromString.compare(pos, 2, "$(") == 0 && end != std::string::npos)
+  {
+    throw std::invalid_argument("Cannot find algorithm: " +
+      fromString.substr(pos + 2, end - pos - 2));
+  }
+
+  throw std::invalid_argument("Invalid algorithm: unexpected '" +
+    fromString.substr(pos, 1) + "' at position " + std::to_string(pos));
+}
 
 rcube::Algorithm::Algorithm(const std::vector<rcube::Move>& fromVector)
 {
   this->algorithm = fromVector;
 }
 
-rcube::Algorithm rcube::Algorithm::operator*(const int& factor)
+rcube::Algorithm rcube::Algorithm::operator*(const int& factor) const &
 {
-  rcube::Algorithm result = rcube::Algorithm(algorithm);
+  return rcube::Algorithm(*this) * factor;
+}
 
-  for (auto it = result.algorithm.begin(); it < result.algorithm.end(); ++it)
+rcube::Algorithm rcube::Algorithm::operator*(const int& factor) &&
+{
+  auto dest = algorithm.begin();
+
+  for (const rcube::Move &move : algorithm)
   {
-    int newDirection = (factor * it->direction) % 4;
+    int newDirection = (factor * move.direction) % 4;
     if (newDirection < -1) newDirection += 4;
-    if (newDirection == 0) result.algorithm.erase(it);
+    if (newDirection == 0) continue;
 
-    it->direction = static_cast<MoveDirection>(newDirection);
+    *dest = move;
+    dest->direction = static_cast<MoveDirection>(newDirection);
+    ++dest;
   }
+  algorithm.erase(dest, algorithm.end());
+
+  return std::move(*this);
+}
+
+rcube::Algorithm rcube::Algorithm::operator+(const rcube::Algorithm &a) const &
+{
+  rcube::Algorithm result;
+  result.reserve(length() + a.length());
+  result.append(*this);
+  result.append(a);
   return result;
 }
 
-rcube::Algorithm rcube::Algorithm::operator+(const rcube::Algorithm a)
+rcube::Algorithm rcube::Algorithm::operator+(const rcube::Algorithm &a) &&
+{
+  append(a);
+  return std::move(*this);
+}
+
+rcube::Algorithm& rcube::Algorithm::operator+=(const rcube::Algorithm &a)
 {
-  std::vector<rcube::Move> dest = algorithm;
-  dest.insert(dest.end(), a.algorithm.begin(), a.algorithm.end());
-  return rcube::Algorithm(dest);
+  return append(a);
 }
 
-inline void rcube::Algorithm::push(const rcube::Move &m)
+rcube::Algorithm& rcube::Algorithm::append(const rcube::Algorithm &a)
 {
-  algorithm.push_back(m);
+  algorithm.insert(algorithm.end(), a.algorithm.begin(), a.algorithm.end());
+  return *this;
 }
 
-rcube::Algorithm rcube::Algorithm::generateScramble(const int &length)
+// The moves that turn some of the 3 layers along an axis (ordered from the
+// negative to the positive side), as quarter turns around the positive
+// direction of the axis. Moves along the same axis commute, so any sequence
+// of them is described by the number of quarter turns of each layer.
+struct LayerMove
+{
+  MoveFace face;
+  int layers[3];
+};
+
+#define N_LAYER_MOVES 6
+
+// for each axis: face, opposite face, slice, wide face, wide opposite face and
+// rotation of the whole cube
+static const LayerMove layerMoves[3][N_LAYER_MOVES] = {
+  {
+    {RIGHT, {0, 0, 1}}, {LEFT, {-1, 0, 0}}, {MIDDLE, {0, -1, 0}},
+    {RIGHT_W, {0, 1, 1}}, {LEFT_W, {-1, -1, 0}}, {ROTATE_X, {1, 1, 1}}
+  },
+  {
+    {UP, {0, 0, 1}}, {DOWN, {-1, 0, 0}}, {EQUATOR, {0, -1, 0}},
+    {UP_W, {0, 1, 1}}, {DOWN_W, {-1, -1, 0}}, {ROTATE_Y, {1, 1, 1}}
+  },
+  {
+    {FRONT, {0, 0, 1}}, {BACK, {-1, 0, 0}}, {SIDE, {0, 1, 0}},
+    {FRONT_W, {0, 1, 1}}, {BACK_W, {-1, -1, 0}}, {ROTATE_Z, {1, 1, 1}}
+  }
+};
+
+struct SimplifyTables
 {
-  rcube::Algorithm scramble;
-  srand(time(0));
+  // shortest[axis][rotations][turns] = quarter turns of each move in
+  // layerMoves[axis] that give the layer turns encoded as 16 * turns[0] +
+  // 4 * turns[1] + turns[2], with the fewest moves (preferring R, L, U, D, F
+  // and B). The last move (the rotation) is only used when rotations = 1.
+  int shortest[3][2][64][N_LAYER_MOVES];
 
-  MoveFace moves[6] = {RIGHT, LEFT, UP, DOWN, FRONT, BACK};
-  MoveFace prev;
+  SimplifyTables();
+};
 
-  while (scramble.length() <= length)
+SimplifyTables::SimplifyTables()
+{
+  for (int axis = 0; axis < 3; ++axis)
   {
-    MoveFace move = moves[rand() % 6];
-    while (move == prev)
+    for (int rotations = 0; rotations < 2; ++rotations)
     {
-      move = moves[rand() % 6];
+      int nMoves = rotations ? N_LAYER_MOVES : N_LAYER_MOVES - 1;
+      int bestCost[64];
+      for (int v = 0; v < 64; ++v) bestCost[v] = 1 << 30;
+
+      for (int combo = 0; combo < (1 << (2 * nMoves)); ++combo)
+      {
+        int q[N_LAYER_MOVES] = {0};
+        int turns[3] = {0, 0, 0};
+        int moves = 0, others = 0;
+
+        for (int m = 0; m < nMoves; ++m)
+        {
+          q[m] = (combo >> (2 * m)) & 3;
+          if (q[m] == 0) continue;
+
+          moves++;
+          if (m > 1) others++;
+          for (int l = 0; l < 3; ++l)
+            turns[l] += q[m] * layerMoves[axis][m].layers[l];
+        }
+
+        int v = 0;
+        for (int l = 0; l < 3; ++l) v = v * 4 + ((turns[l] % 4) + 4) % 4;
+
+        int cost = moves * 8 + others;
+        if (cost >= bestCost[v]) continue;
+
+        bestCost[v] = cost;
+        for (int m = 0; m < N_LAYER_MOVES; ++m)
+          shortest[axis][rotations][v][m] = q[m];
+      }
     }
+  }
+}
 
-    int dir = rand() % 3; // {0, 1, 2}
-    if (dir == 0) dir = -1; // {-1, 1, 2}
+static const SimplifyTables& getSimplifyTables()
+{
+  static const SimplifyTables tables;
+  return tables;
+}
+
+// a maximal run of moves along the same axis
+struct MoveGroup
+{
+  int axis;
+  int turns[3]; // quarter turns of each layer (mod 4)
+  bool rotations; // whether the group contains rotations of the whole cube
+};
 
-    scramble.push(rcube::Move(move, static_cast<MoveDirection>(dir)));
-    prev = move;
+static void addToGroup(MoveGroup *group, const rcube::Move &move)
+{
+  int q = (((int)move.direction % 4) + 4) % 4;
+
+  for (int m = 0; m < N_LAYER_MOVES; ++m)
+  {
+    const LayerMove &lm = layerMoves[group->axis][m];
+    if (lm.face != move.face) continue;
+
+    for (int l = 0; l < 3; ++l)
+      group->turns[l] = ((group->turns[l] + q * lm.layers[l]) % 4 + 4) % 4;
+
+    if (m == N_LAYER_MOVES - 1) group->rotations = true;
+    return;
   }
-  return scramble;
+  throw std::invalid_argument("Unsupported move: " + move.to_string());
 }
 
 void rcube::Algorithm::normalize()
 {
-  if (algorithm.size() == 0) return;
-  
-  for (auto it = algorithm.begin(); it < algorithm.end() - 1;)
+  // Consecutive moves along the same axis commute, so they are merged into a
+  // group. When the moves of a group cancel out the group is popped, and the
+  // previous one can merge with the following moves (e.g. RUU'R' is empty).
+  // Each group is then rewritten with as few moves as possible, in a fixed
+  // order. Rotations are only used for groups that already contained some, so
+  // an algorithm without rotations stays without rotations.
+
+  // the groups of short algorithms are kept on the stack
+  MoveGroup inlineGroups[rcube::MoveVector::INLINE_SIZE];
+  std::vector<MoveGroup> heapGroups;
+  MoveGroup *groups = inlineGroups;
+  if (algorithm.size() > rcube::MoveVector::INLINE_SIZE)
   {
-    if (it->face != (it + 1)->face)
-    {
-      ++it;
-      continue;
-    }
+    heapGroups.resize(algorithm.size());
+    groups = heapGroups.data();
+  }
+  int nGroups = 0;
 
-    int newDir = (int)it->direction + (int)(it + 1)->direction;
-    newDir = (newDir + 4) % 4;
-    if (newDir == 3) newDir = -1;
+  for (const rcube::Move &move : algorithm)
+  {
+    if (nGroups == 0 || groups[nGroups - 1].axis != (int)move.axis)
+      groups[nGroups++] = {(int)move.axis, {0, 0, 0}, false};
 
-    it->direction = static_cast<MoveDirection>(newDir);
-    
-    algorithm.erase(it + 1);
+    MoveGroup &group = groups[nGroups - 1];
+    addToGroup(&group, move);
+
+    if (group.turns[0] == 0 && group.turns[1] == 0 && group.turns[2] == 0)
+      nGroups--;
+  }
 
-    if (newDir == 0)
+  const SimplifyTables &tables = getSimplifyTables();
+  algorithm.clear();
+
+  for (int i = 0; i < nGroups; ++i)
+  {
+    const MoveGroup &group = groups[i];
+    int v = group.turns[0] * 16 + group.turns[1] * 4 + group.turns[2];
+    const int *q = tables.shortest[group.axis][group.rotations][v];
+
+    for (int m = 0; m < N_LAYER_MOVES; ++m)
     {
-      algorithm.erase(it);
+      if (q[m] == 0) continue;
+      push(rcube::Move(layerMoves[group.axis][m].face, q[m] == 3 ? -1 : q[m]));
     }
   }
 }
@@ -201,96 +359,153 @@ void rcube::Algorithm::normalize()
 rcube::Algorithm rcube::Algorithm::reverse() const
 {
   rcube::Algorithm newAlgo;
+  newAlgo.reserve(length());
 
-  for (auto it = algorithm.end() - 1; it >= algorithm.begin(); --it)
-  {
-    int newDir = (int)it->direction;
-    if (abs(newDir) == 1) newDir *= -1;
-
-    newAlgo.push(rcube::Move(it->face, newDir));
-  }
+  for (rcube::Move move : reversed()) newAlgo.push(move);
 
   return newAlgo;
 }
 
-void editFaceMap(std::map<rcube::Orientation, rcube::Orientation> *faceMap,
-  Axis axis, int direction)
+// The 24 orientations of the whole cube. An orientation is described by the
+// face that each of the 6 faces (numbered as in rcube::PackedState::faceIndex)
+// has been moved to by the rotations performed so far.
+struct RotationTables
+{
+  // next[r][axis][q] = orientation after q quarter turns around axis
+  int next[24][3][4];
+
+  // original[r][f] = face that has been moved to the face f
+  int original[24][6];
+
+  RotationTables();
+};
+
+RotationTables::RotationTables()
 {
-  for (auto it = faceMap->begin(); it != faceMap->end(); ++it)
+  std::vector<rcube::Orientation> faces = rcube::Orientation::iterate();
+  rcube::Orientation states[24][6];
+  int nStates = 1;
+
+  for (int f = 0; f < 6; ++f)
+    states[0][rcube::PackedState::faceIndex(faces[f])] = faces[f];
+
+  for (int r = 0; r < nStates; ++r)
   {
-    it->second.rotate(axis, direction);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      for (int q = 0; q < 4; ++q)
+      {
+        rcube::Orientation rotated[6];
+        for (int f = 0; f < 6; ++f)
+        {
+          rotated[f] = states[r][f];
+          rotated[f].rotate((Axis)axis, q);
+        }
+
+        int idx = 0;
+        while (idx < nStates)
+        {
+          int f = 0;
+          while (f < 6 && states[idx][f] == rotated[f]) ++f;
+          if (f == 6) break;
+          ++idx;
+        }
+
+        if (idx == nStates)
+        {
+          for (int f = 0; f < 6; ++f) states[nStates][f] = rotated[f];
+          nStates++;
+        }
+        next[r][axis][q] = idx;
+      }
+    }
+
+    for (int f = 0; f < 6; ++f)
+      original[r][rcube::PackedState::faceIndex(states[r][f])] = f;
   }
 }
 
-void removeRotationsUnit(const rcube::Algorithm &algo, rcube::Algorithm *newAlgo,
-  std::map<rcube::Orientation, rcube::Orientation> *faceMap)
+static const RotationTables& getRotationTables()
+{
+  static const RotationTables tables;
+  return tables;
+}
+
+// the face moves, numbered as in rcube::PackedState::faceIndex
+static const MoveFace faceMoves[6] = {LEFT, RIGHT, DOWN, UP, BACK, FRONT};
+
+// slice and wide moves written as face moves and rotations
+struct MoveExpansion
 {
-  for (rcube::Move mv : algo.algorithm)
+  MoveFace face;
+  int length;
+  struct { MoveFace face; int direction; } moves[3];
+};
+
+static const MoveExpansion expansions[] = {
+  {MIDDLE, 3, {{RIGHT, 1}, {LEFT, -1}, {ROTATE_X, -1}}},
+  {EQUATOR, 3, {{UP, 1}, {DOWN, -1}, {ROTATE_Y, -1}}},
+  {SIDE, 3, {{FRONT, -1}, {BACK, 1}, {ROTATE_Z, 1}}},
+  {UP_W, 2, {{DOWN, 1}, {ROTATE_Y, 1}}},
+  {FRONT_W, 2, {{BACK, 1}, {ROTATE_Z, 1}}},
+  {RIGHT_W, 2, {{LEFT, 1}, {ROTATE_X, 1}}},
+  {LEFT_W, 2, {{RIGHT, 1}, {ROTATE_X, -1}}},
+  {DOWN_W, 2, {{UP, 1}, {ROTATE_Y, -1}}},
+  {BACK_W, 2, {{FRONT, 1}, {ROTATE_Z, -1}}}
+};
+
+static void pushWithoutRotations(rcube::Algorithm *newAlgo, int *orientation,
+  const rcube::Move &mv)
+{
+  const RotationTables &tables = getRotationTables();
+  int q = (((int)mv.direction % 4) + 4) % 4;
+
+  switch (mv.face)
   {
-    switch (mv.face)
+    case ROTATE_X:
+    case ROTATE_Y:
+    case ROTATE_Z:
+      *orientation = tables.next[*orientation][mv.axis][q];
+      return;
+
+    case RIGHT:
+    case LEFT:
+    case UP:
+    case DOWN:
+    case FRONT:
+    case BACK:
     {
-      case ROTATE_X:
-        editFaceMap(faceMap, Axis::X, mv.direction); break;
-      case ROTATE_Y:
-        editFaceMap(faceMap, Axis::Y, mv.direction); break;
-      case ROTATE_Z:
-        editFaceMap(faceMap, Axis::Z, mv.direction); break;
+      int f = rcube::PackedState::faceIndex(mv.getAffectedFace());
+      newAlgo->push(rcube::Move(faceMoves[tables.original[*orientation][f]],
+        mv.direction));
+      return;
+    }
 
-      case MIDDLE:
-      case SIDE:
-      case EQUATOR:
-      {
-        std::map<MoveFace, std::string> algos = {
-          {MIDDLE, "RL'x'"},
-          {EQUATOR, "UD'y'"},
-          {SIDE, "F'Bz"}
-        };
-
-        rcube::Algorithm expansion(algos[mv.face]);
-        removeRotationsUnit(expansion * mv.direction, newAlgo, faceMap);
-      }
+    default: break;
+  }
 
-      case UP_W:
-      case FRONT_W:
-      case RIGHT_W:
-      case LEFT_W:
-      case DOWN_W:
-      case BACK_W:
-      {
-        std::map<MoveFace, std::string> algos = {
-          {UP_W, "Dy"},
-          {FRONT_W, "Bz"},
-          {RIGHT_W, "Lx"},
-          {LEFT_W, "Rx'"},
-          {DOWN_W, "Uy'"},
-          {BACK_W, "Fz'"}
-        };
-
-        rcube::Algorithm expansion(algos[mv.face]);
-        removeRotationsUnit(expansion * mv.direction, newAlgo, faceMap);
-      }
+  for (const MoveExpansion &exp : expansions)
+  {
+    if (exp.face != mv.face) continue;
 
-      default:
-        rcube::Orientation affFace = mv.getAffectedFace();
-        for (auto it = faceMap->begin(); it != faceMap->end(); ++it)
-        {
-          if (it->second == affFace)
-            newAlgo->push(rcube::Move(it->first, mv.direction));
-        }
-        break;
+    for (int i = 0; i < exp.length; ++i)
+    {
+      int dir = ((exp.moves[i].direction * mv.direction) % 4 + 4) % 4;
+      pushWithoutRotations(newAlgo, orientation,
+        rcube::Move(exp.moves[i].face, dir == 3 ? -1 : dir));
     }
+    return;
   }
 }
 
 rcube::Algorithm rcube::Algorithm::withoutRotations() const
 {
   rcube::Algorithm newAlgo;
-  std::map<rcube::Orientation, rcube::Orientation> faceMap;
+  newAlgo.reserve(length());
 
-  for (rcube::Orientation ort : rcube::Orientation::iterate())
-    faceMap.insert(std::pair<rcube::Orientation, rcube::Orientation>(ort, ort));
-
-  removeRotationsUnit(algorithm, &newAlgo, &faceMap);
+  int orientation = 0; // no rotations performed
+  for (const rcube::Move &mv : algorithm)
+    pushWithoutRotations(&newAlgo, &orientation, mv);
 
   newAlgo.normalize();
   return newAlgo;
@@ -298,7 +513,7 @@ rcube::Algorithm rcube::Algorithm::withoutRotations() const
 
 void rcube::Algorithm::removeRotations()
 {
-  algorithm = withoutRotations().algorithm;
+  algorithm = std::move(withoutRotations().algorithm);
 }
 
 std::string rcube::Algorithm::to_string() const
@@ -319,7 +534,37 @@ std::string rcube::Algorithm::to_string() const
   return ss.str();
 }
 
-inline int rcube::Algorithm::length() const
+bool rcube::Algorithm::operator==(const rcube::Algorithm &a) const
+{
+  return algorithm == a.algorithm;
+}
+
+bool rcube::Algorithm::operator!=(const rcube::Algorithm &a) const
+{
+  return !(*this == a);
+}
+
+uint64_t rcube::Algorithm::getHash() const
 {
-  return algorithm.size();
-}
\ No newline at end of file
+  // FNV-1a over the (face, direction) pairs
+  uint64_t hash = 0xcbf29ce484222325;
+
+  for (const rcube::Move &move : algorithm)
+  {
+    hash = (hash ^ (uint8_t)move.face) * 0x100000001b3;
+    hash = (hash ^ (uint8_t)move.direction) * 0x100000001b3;
+  }
+  return hash;
+}
+
+rcube::PackedState rcube::Algorithm::compile() const
+{
+  rcube::PackedState res;
+  res.performAlgorithm(*this);
+  return res;
+}
+
+int rcube::Algorithm::getOrder() const
+{
+  return compile().getOrder();
+}
@@ -23,6 +23,8 @@
 *   identify them
 * - PLL: they all contain a regex for rcube::Cube::layerMatches to identify
 *   them
+* The CFOP solver indexes the OLL and PLL algorithms that have a regex by the
+* state they solve (see lastLayer.hpp), the first one solving a case wins.
 */
 
 std::vector<AlgoDBItem> algoDb
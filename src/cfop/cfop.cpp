@@ -9,14 +9,17 @@
 
 #include <iostream>
 #include <algorithm>
+#include <thread>
+#include <atomic>
+#include <climits>
 
 #include <rcube.hpp>
 #include <solving.hpp>
 
 #include "util.hpp"
-#include "algoDButil.hpp"
-
-extern std::vector<AlgoDBItem> algoDb;
+#include "lastLayer.hpp"
+#include "../kociemba/cross.hpp"
+#include "../kociemba/f2l.hpp"
 
 
 CfopSolver::CfopSolver(const rcube::Cube &cube, Color crossColor, bool verbose)
@@ -26,14 +29,7 @@ CfopSolver::CfopSolver(const rcube::Cube &cube, Color crossColor, bool verbose)
 rcube::Algorithm CfopSolver::solve()
 {
     rcube::Algorithm algo;
-
-    algo = algo + cross();
-    algo = algo + f2l();
-    algo = algo + oll();
-    algo = algo + pll();
-
-    algo.normalize();
-    algo.removeRotations();
+    solveStages(&algo, nullptr, 0);
 
     if (_verbose)
     {
@@ -44,422 +40,125 @@ rcube::Algorithm CfopSolver::solve()
     return algo;
 }
 
-void rotateU(rcube::Cube *cube, rcube::Algorithm *algo, rcube::Coordinates
-    *edgePos = nullptr, rcube::Coordinates *cornerPos = nullptr)
-{
-    cube->performMove(rcube::Move('U', 1));
-    algo->push(rcube::Move('U', 1));
-
-    if (edgePos != nullptr) edgePos->rotate(Axis::Y, 1);
-    if (cornerPos != nullptr) cornerPos-> rotate(Axis::Y, 1);
-}
-
-rcube::Algorithm CfopSolver::cross()
+rcube::Algorithm CfopSolver::solveColorNeutral()
 {
-    rcube::Algorithm algo;
-    auto crossEdges = getAdjacentColors(_crossColor);
-    algo = algo + _cube.rotateTo(getOppositeColor(_crossColor), crossEdges[0]);
-
-    for (Color edgeColor : crossEdges)
-    {
-    
-    rcube::Coordinates edgePos = _cube.find(_crossColor, edgeColor);
-    rcube::Orientation cOrient = _cube.getStickerOrientation(edgePos, _crossColor);
-    rcube::Coordinates place = getBlockPlace(&_cube, _crossColor, edgeColor);
-
-    // skip if already in place
-    if (edgePos == place && cOrient.axis == Axis::Y) continue;
-
-    // with -Y orientation but wrong place -> pull to +Y
-    if (edgePos.y() == -1 && cOrient.axis == Axis::Y)
-    {
-        if (edgeColor == crossEdges[0])
-        {
-            while (edgePos != place)
-            {
-                _cube.performMove(rcube::Move('D', 1));
-                algo.push(rcube::Move('D', 1));
-                edgePos.rotate(Axis::Y, -1);
-            }
-            continue;
-        }
-        rcube::Move mv(_cube.getStickerOrientation(edgePos, edgeColor), 2);
-        _cube.performMove(mv);
-        algo.push(mv);
-    }
-
-    // in boottom layer but with wrong orientation -> pull to top layer
-    else if (edgePos.y() == -1 && cOrient.axis != Axis::Y)
-    {
-        rcube::Move mv(cOrient, 2);
-        _cube.performMove(mv);
-        algo.push(mv);
-
-        edgePos.rotate(cOrient.axis, 2);
-    }
-
-    // in top layer but with orientation != +Y -> pair with center and pull down
-    if (edgePos.y() == 1 && cOrient.axis != Axis::Y)
-    {
-        rcube::Algorithm tmpAlgo;
-
-        if (place.coords[cOrient.axis] != 0)
-        {
-            rotateU(&_cube, &algo, &edgePos);
-            cOrient.rotate(Axis::Y, 1);
-        }
-        rcube::Move mv(cOrient, cOrient.direction * (place.x() +
-            place.z()) * (cOrient.axis - 1));
-        tmpAlgo.push(mv);
-        edgePos.rotate(cOrient.axis, mv.direction * cOrient.direction);
-
-        rcube::Move mv1({Axis::X, place.x()}, -place.x() * edgePos.z());
-        if (place.z() != 0)
-        {
-            mv1 = rcube::Move({Axis::Z, place.z()}, place.z() * edgePos.x());
-        }
-        tmpAlgo.push(mv1);
-
-        if (_cube.getStickerAt(rcube::Coordinates(mv.getAffectedFace(),
-            {Axis::Y, -1}), {Axis::Y, -1}) == _crossColor)
-        {
-            tmpAlgo.push(mv.getInverted());
-        }
-
-        _cube.performAlgorithm(tmpAlgo);
-        algo = algo + tmpAlgo;
-        continue;
-    }
-
-    edgePos = _cube.find(_crossColor, edgeColor);
-    cOrient = _cube.getStickerOrientation(edgePos, _crossColor);
-
-    // in middle layer -> line
-    if (edgePos.y() == 0)
-    {
-        // already lined up with center -> just move down
-        if ((place.x() == 0 && place.z() == edgePos.z() && cOrient.axis ==
-            Axis::X) || place.z() == 0 && place.x() == edgePos.x() &&
-            cOrient.axis == Axis::Z)
-        {
-            rcube::Move mv(_cube.getFaceOrientation(edgeColor), 1);
-
-            while (edgePos.y() != -1)
-            {
-                _cube.performMove(mv);
-                algo.push(mv);
-                edgePos = _cube.find(_crossColor, edgeColor);
-            }
-            continue;
-        }
-
-        rcube::Move mv('U', 1);
-
-        if (cOrient.axis == Axis::X)
-        {
-            mv = rcube::Move({Axis::Z, edgePos.z()},
-                -cOrient.direction * edgePos.z());
-        }
-        else if (cOrient.axis == Axis::Z)
-        {
-            mv = rcube::Move({Axis::X, edgePos.x()},
-                cOrient.direction * edgePos.x());
-        }
-        rcube::Algorithm tmpAlgo({mv, rcube::Move('U', 1)});
-
-        if (_cube.getStickerAt(rcube::Coordinates(mv.getAffectedFace(),
-            {Axis::Y, -1}), {Axis::Y, -1}) == _crossColor)
-        {
-            tmpAlgo.push(mv.getInverted());
-        }
+    static const Color colors[6] = {Color::White, Color::Yellow, Color::Green,
+        Color::Blue, Color::Red, Color::Orange};
 
-        _cube.performAlgorithm(tmpAlgo);
-        algo = algo + tmpAlgo;
+    // each color is solved on its own copy of the cube. The best solution
+    // found so far is shared (as length * 8 + color index, so that ties are
+    // broken by the order of colors and the result is deterministic) to stop
+    // the colors that can no longer beat it
+    std::atomic<int> best(INT_MAX);
+    rcube::Algorithm solutions[6];
+    std::thread threads[6];
 
-        edgePos = _cube.find(_crossColor, edgeColor);
-        cOrient = _cube.getStickerOrientation(edgePos, _crossColor);
-    }
-
-    // orientation +Y -> line up with center and bring down
-    if (edgePos.y() == 1)
+    for (int i = 0; i < 6; ++i)
     {
-        while (edgePos.x() != place.x() || edgePos.z() != place.z())
-        {
-            _cube.performMove(rcube::Move('U', 1));
-            algo.push(rcube::Move('U', 1));
-            edgePos = _cube.find(_crossColor, edgeColor);
-        }
-
-        rcube::Move mv(_cube.getStickerOrientation(edgePos, edgeColor), 2);
-        _cube.performMove(mv);
-        algo.push(mv);
+        threads[i] = std::thread([&, i]() {
+            CfopSolver solver(_cube, colors[i]);
+            solver._zbls = _zbls;
+            solver.solveStages(&solutions[i], &best, i);
+        });
     }
+    for (int i = 0; i < 6; ++i) threads[i].join();
 
-
-    } // for (Color edgeColor : crossEdges)
-
-    algo.normalize();
+    int bestIdx = best.load() % 8;
 
     if (_verbose)
     {
-        std::cout << "[CFOP] Cross: " << algo.to_string() << std::endl;
+        std::cout << "[CFOP] Best cross color: " << (char)colors[bestIdx]
+            << std::endl;
+        std::cout << "[CFOP] Final algorithm: " << solutions[bestIdx]
+            .to_string() << std::endl;
+        std::cout << "[CFOP] Cube solved in " << solutions[bestIdx].length()
+            << " moves\n";
     }
 
-    return algo;
+    return solutions[bestIdx];
 }
 
-bool isEmptySlot(const rcube::Coordinates &pos,
-    const std::vector<rcube::Coordinates> &fullSlots)
+// Returns a lower bound of the length of any solution starting with the
+// partial solution algo. normalize() only merges the moves of the next stages
+// with the last moves of algo along the same axis (cancelling more would
+// require undoing the pairs already inserted), so these are not counted
+static int partialLength(const rcube::Algorithm &algo)
 {
-    for (rcube::Coordinates place : fullSlots)
-    {
-        if (place.x() == pos.x() && place.z() == pos.z()) return false;
-    }
-    return true;
-}
+    rcube::Algorithm tmp = algo;
+    tmp.normalize();
+    tmp.removeRotations();
 
-rcube::Coordinates toBeEmpty(const rcube::Coordinates &pos,
-    const rcube::Orientation &layer)
-{
-    if (layer.axis == Axis::X)
+    int length = tmp.length();
+    for (int i = length - 1; i >= 0; --i)
     {
-        return rcube::Coordinates(pos.x(), 1, -pos.z());
+        if (tmp.algorithm[i].axis != tmp.algorithm[length - 1].axis) break;
+        --length;
     }
-    return rcube::Coordinates(-pos.x(), 1, pos.z());
+    return length;
 }
 
-rcube::Coordinates computeEdgePlace(const rcube::Coordinates &cPos,
-    const rcube::Orientation &cOrient)
+bool CfopSolver::solveStages(rcube::Algorithm *algo, std::atomic<int> *best,
+    int rank)
 {
-    if (cOrient.axis == Axis::X) return rcube::Coordinates(0, 1, -cPos.z());
-    return rcube::Coordinates(-cPos.x(), 1, 0);
-}
-
-bool pairIsFormed(rcube::Cube *cube, const rcube::Coordinates &cPos, const
-    rcube::Coordinates &ePos, const rcube::Orientation &cOrient)
-{
-    if (cube->getStickerAt(cPos, {Axis::Y, 1}) != cube->getStickerAt(ePos,
-        {Axis::Y, 1})) return false;
-
-    if (cOrient.axis == Axis::Z) return cPos.x() == ePos.x();
-    return cPos.z() == ePos.z();
-}
-
-rcube::Algorithm solveF2lPair(rcube::Cube cube, Color crossColor, Color c1,
-    Color c2, const std::vector<rcube::Coordinates> &fullSlots)
-{
-    rcube::Algorithm algo;
-    
-    rcube::Coordinates edgePos = cube.find(c1, c2);
-    rcube::Coordinates cornerPos = cube.find(c1, c2, crossColor);
-    rcube::Orientation cOrient = cube.getStickerOrientation(cornerPos, crossColor);
-
-    if (blockIsInPlace(&cube, edgePos) && blockIsInPlace(&cube, cornerPos))
+    if (best == nullptr)
     {
-        return algo;
+        *algo += cross();
+        *algo += f2l();
     }
-
-    /****************************** Place corner ******************************/
-
-    if (cornerPos.y() == 1 && cOrient.axis == Axis::Y)
+    else
     {
-        while (!isEmptySlot(cornerPos, fullSlots))
+        // the color is dropped as soon as its cross and the pairs inserted so
+        // far are as long as the best solution
+        rcube::Algorithm pairs;
+        *algo += cross();
+        do
         {
-            rotateU(&cube, &algo, nullptr, &cornerPos);
+            if (partialLength(*algo + pairs) * 8 + rank > best->load())
+                return false;
         }
+        while (insertPair(&pairs));
 
-        rcube::Move mv1 = pullUp(cornerPos);
-        rcube::Orientation layer = mv1.getAffectedFace();
-        rcube::Algorithm tmpAlgo({mv1, getUmove(cornerPos.getRotated(layer.axis,
-            layer.direction * mv1.direction), mv1.getAffectedFace()),
-            mv1.getInverted()});
-
-        cube.performAlgorithm(tmpAlgo);
-        algo = algo + tmpAlgo;
-    }
-    else if (cornerPos.y() == -1)
-    {
-        rcube::Orientation layer = (cOrient.axis != Axis::Y) ? cOrient :
-            (rcube::Orientation){Axis::X, cornerPos.x()};
-        
-        int direction = (cornerPos.getRotated(layer.axis, layer.direction).y());
-        rcube::Move mv(layer, (direction == 1) ? 1 : -1);
-        rcube::Algorithm tmpAlgo({mv, getUmove(cornerPos, layer),
-            mv.getInverted()});
-
-        cube.performAlgorithm(tmpAlgo);
-        algo = algo + tmpAlgo;
+        pairs.normalize();
+        *algo += pairs;
     }
+    *algo += oll();
+    *algo += pll();
 
-    cornerPos = cube.find(c1, c2, crossColor);
-    edgePos = cube.find(c1, c2);
-    cOrient = cube.getStickerOrientation(cornerPos, crossColor);
+    algo->normalize();
+    algo->removeRotations();
 
-    /******************************* Place edge *******************************/
-
-    rcube::Coordinates edgePlace = computeEdgePlace(cornerPos, cOrient);
-
-    if (edgePos.y() == 1 && edgePos != edgePlace && !pairIsFormed(&cube,
-        cornerPos, edgePos, cOrient))
+    if (best != nullptr)
     {
-        rcube::Orientation layer;
-
-        while (true)
-        {
-            layer = cOrient;
-            if (edgePos.coords[layer.axis] == layer.direction)
-            {
-                layer.axis = (Axis)((layer.axis + 2) % 4); // 0->2, 2->0
-                layer.direction = cornerPos.coords[layer.axis];
-            }
-
-            if (isEmptySlot(toBeEmpty(cornerPos, layer), fullSlots)) break;
-
-            rotateU(&cube, &algo, &edgePos, &cornerPos);
-            cOrient.rotate(Axis::Y, 1);
-        }
-        edgePlace = computeEdgePlace(cornerPos, cOrient);
-
-        // ready to form a pair
-        if (cube.getStickerAt(cornerPos, {Axis::Y, 1}) == cube.getStickerAt(
-            edgePos, {Axis::Y, 1}) && layer == cOrient &&
-            edgePos.coords[cOrient.axis] != cOrient.direction)
-        {
-            edgePlace = cornerPos;
-            edgePlace.coords[layer.axis] = 0;
-        }
-
-        rcube::Move mv(layer, 1);
-        if (cornerPos.getRotated(layer.axis, layer.direction).y() != -1)
-        {
-            mv = mv.getInverted();
-        }
-        cube.performMove(mv);
-        algo.push(mv);
-
-        while (edgePos != edgePlace)
-        {
-            rotateU(&cube, &algo, &edgePos);
-        }
-
-        cube.performMove(mv.getInverted());
-        algo.push(mv.getInverted());
-    }
-
-    else if (edgePos.y() == 0)
-    {
-        rcube::Orientation layer;
-
-        while (true)
-        {
-            if (edgePos.x() == edgePlace.x())
-            {
-                layer = {Axis::X, edgePos.x()};
-                break;
-            }
-            else if (edgePos.z() == edgePlace.z())
-            {
-                layer = {Axis::Z, edgePos.z()};
-                break;
-            }
-            rotateU(&cube, &algo, &edgePlace, &cornerPos);
-        }
-
-        rcube::Move mv(layer, 1);
-        if (edgePos.getRotated(layer.axis, layer.direction).y() != 1)
-        {
-            mv = mv.getInverted();
-        }
-        cube.performMove(mv);
-        algo.push(mv);
-
-        cOrient = cube.getStickerOrientation(cornerPos, crossColor);
-        while (cOrient != layer.getInv())
-        {
-            rotateU(&cube, &algo);
-            cOrient.rotate(Axis::Y, 1);
-        }
-
-        cube.performMove(mv.getInverted());
-        algo.push(mv.getInverted());
+        int value = algo->length() * 8 + rank;
+        int current = best->load();
+        while (value < current &&
+            !best->compare_exchange_weak(current, value));
     }
+    return true;
+}
 
-    /******************************** Join pair ********************************/
+void CfopSolver::useZbls(bool enable)
+{
+    _zbls = enable;
+}
 
-    rcube::Coordinates cPlace = getBlockPlace(&cube, crossColor, c1, c2);
-    edgePos = cube.find(c1, c2);
-    cornerPos = cube.find(c1, c2, crossColor);
+rcube::Algorithm CfopSolver::cross()
+{
+    rcube::Algorithm algo;
+    auto crossEdges = getAdjacentColors(_crossColor);
+    algo += _cube.rotateTo(getOppositeColor(_crossColor), crossEdges[0]);
 
-    if (cube.getStickerAt(edgePos, {Axis::Y, 1}) != cube.getStickerAt(
-        cornerPos, {Axis::Y, 1}))
-    {
-        while (cornerPos.x() != cPlace.x() || cornerPos.z() != cPlace.z())
-        {
-            rotateU(&cube, &algo, &edgePos, &cornerPos);
-        }
+    // the cross color is now on the bottom face: the shortest cross is found
+    // on the state seen from the current orientation of the cube
+    Kociemba::CubieCube cc(_cube.getState().getReoriented());
+    rcube::Algorithm cross = Kociemba::solveCross(cc);
 
-        cOrient = cube.getStickerOrientation(cornerPos, crossColor);
-        rcube::Move mv(cOrient, 1);
-        rcube::Coordinates afterRot = cornerPos.getRotated(cOrient.axis,
-            cOrient.direction);
-        if (afterRot.y() != 1)
-        {
-            mv = mv.getInverted();
-            afterRot.rotate(cOrient.axis, 2);
-        }
-        rcube::Move mv1 = getUmove(afterRot, cOrient).getInverted();
+    _cube.performAlgorithm(cross);
+    algo += cross;
 
-        rcube::Algorithm tmpAlgo({mv, mv1, mv.getInverted()});
-        cube.performAlgorithm(tmpAlgo);
-        algo = algo + tmpAlgo;
-    }
-    else
+    if (_verbose)
     {
-        if (cornerPos.x() != edgePos.x() && cornerPos.z() != edgePos.z())
-        {
-            cOrient = cube.getStickerOrientation(cornerPos, crossColor);
-
-            while (!isEmptySlot(toBeEmpty(cornerPos, cOrient), fullSlots))
-            {
-                rotateU(&cube, &algo, &edgePos, &cornerPos);
-                cOrient.rotate(Axis::Y, 1);
-            }
-
-            cOrient = cube.getStickerOrientation(cornerPos, crossColor);
-            rcube::Move mv(cOrient, 1);
-            if (cornerPos.getRotated(cOrient.axis, cOrient.direction).y() != -1)
-                mv = mv.getInverted();
-
-            rcube::Algorithm tmpAlgo({mv, rcube::Move('U', 2), mv.getInverted()});
-            cube.performAlgorithm(tmpAlgo);
-            algo = algo + tmpAlgo;
-
-            edgePos = cube.find(c1, c2);
-            cornerPos = cube.find(c1, c2, crossColor);
-        }
-
-        cOrient = cube.getStickerOrientation(cornerPos, crossColor);
-        rcube::Coordinates thirdPos = cornerPos;
-        thirdPos.coords[cOrient.axis] *= -1;
-
-        while (thirdPos.x() != cPlace.x() || thirdPos.z() != cPlace.z())
-        {
-            rotateU(&cube, &algo, &thirdPos, &cornerPos);
-            cOrient.rotate(Axis::Y, 1);
-        }
-
-        rcube::Move mv1(cOrient.getInv(), 1);
-        if (cPlace.getRotated(cOrient.axis, -cOrient.direction).y() != 1)
-            mv1 = mv1.getInverted();
-
-        rcube::Move mv2('U', 1);
-        rcube::Coordinates afterRot = cornerPos.getRotated(Axis::Y, 1);
-        if (afterRot.x() != cPlace.x() || afterRot.z() != cPlace.z())
-            mv2 = mv2.getInverted();
-
-        rcube::Algorithm tmpAlgo({mv1, mv2, mv1.getInverted()});
-        cube.performAlgorithm(tmpAlgo);
-        algo = algo + tmpAlgo;
+        std::cout << "[CFOP] Cross: " << algo.to_string() << std::endl;
     }
 
     return algo;
@@ -468,45 +167,7 @@ rcube::Algorithm solveF2lPair(rcube::Cube cube, Color crossColor, Color c1,
 rcube::Algorithm CfopSolver::f2l()
 {
     rcube::Algorithm algo;
-    std::vector<rcube::Coordinates> fullSlots;
-    auto crossColors = getAdjacentColors(_crossColor);
-
-    while (fullSlots.size() < 4)
-    {
-        rcube::Algorithm pairAlgo, tmpAlgo;
-
-        int lowestIdx;
-        int lowestSize = 100;
-
-        for (int i = 0; i < 4; ++i)
-        {
-            Color c1 = crossColors[i];
-            Color c2 = crossColors[(i + 1) % 4];
-
-            if (std::find(fullSlots.begin(), fullSlots.end(),
-                getBlockPlace(&_cube, _crossColor, c1, c2)) != fullSlots.end())
-            {
-                continue;
-            }
-
-            tmpAlgo = solveF2lPair(_cube, _crossColor, c1, c2, fullSlots);
-
-            if (tmpAlgo.length() < lowestSize)
-            {
-                lowestIdx = i;
-                lowestSize = tmpAlgo.length();
-                pairAlgo = tmpAlgo;
-            }
-        }
-
-        _cube.performAlgorithm(pairAlgo);
-        algo = algo + pairAlgo;
-
-        Color c1 = crossColors[lowestIdx];
-        Color c2 = crossColors[(lowestIdx + 1) % 4];
-        fullSlots.push_back(getBlockPlace(&_cube, _crossColor, c1, c2));
-    }
-
+    while (insertPair(&algo));
     algo.normalize();
 
     if (_verbose)
@@ -517,30 +178,52 @@ rcube::Algorithm CfopSolver::f2l()
     return algo;
 }
 
-rcube::Algorithm CfopSolver::oll()
+bool CfopSolver::insertPair(rcube::Algorithm *algo)
 {
-    rcube::Algorithm preAlgo("");
-    rcube::Algorithm algo("");
+    // the slots are filled one at a time, always choosing the pair that takes
+    // the fewest moves to insert (the search keeps the cross and the pairs
+    // inserted before in place)
+    Kociemba::CubieCube cc(_cube.getState().getReoriented());
+    int solved = Kociemba::getSolvedSlots(cc);
+    if (solved == 0x0f) return false;
+
+    // in ZBLS mode the last pair also orients the last layer edges
+    int eo = 0;
+    if (_zbls && (solved == 0x07 || solved == 0x0b || solved == 0x0d ||
+        solved == 0x0e)) eo = F2L_ORIENT_EDGES;
+
+    rcube::Algorithm pairAlgo;
+    for (int slot = 0, found = 0; slot < 4; ++slot)
+    {
+        if (solved & (1 << slot)) continue;
+
+        rcube::Algorithm tmpAlgo = Kociemba::solveF2l(cc, (1 << slot) | eo);
+        if (!found++ || tmpAlgo.length() < pairAlgo.length())
+            pairAlgo = tmpAlgo;
+    }
 
-    const rcube::Orientation TOP = {Axis::Y, 1};
-    const rcube::Orientation BACK = {Axis::Z, -1};
-    const rcube::Coordinates BACK_LEFT(-1, 1, -1);
+    _cube.performAlgorithm(pairAlgo);
+    *algo += pairAlgo;
+    return true;
+}
 
-    for (AlgoDBItem item : algoDb)
+rcube::Algorithm CfopSolver::oll()
+{
+    rcube::Algorithm lastLayer;
+    if (getLastLayerAlgorithm(_cube.getState(), &lastLayer))
     {
-        if (item.type != AlgoType::OLL || item.match == "") continue;
+        _cube.performAlgorithm(lastLayer);
 
-        if (_cube.layerAndFaceMatch(TOP, item.match, BACK_LEFT, BACK, &preAlgo))
+        if (_verbose)
         {
-            algo = rcube::Algorithm(item.algo);
-            break;
+            std::cout << "[CFOP] 1LLL: " << lastLayer.to_string() << std::endl;
         }
+
+        return lastLayer;
     }
-    _cube.performAlgorithm(algo);
-    
 
-    algo = preAlgo + algo;
-    algo.normalize();
+    rcube::Algorithm algo = getOllAlgorithm(_cube.getState());
+    _cube.performAlgorithm(algo);
 
     if (_verbose)
     {
@@ -552,35 +235,9 @@ rcube::Algorithm CfopSolver::oll()
 
 rcube::Algorithm CfopSolver::pll()
 {
-    rcube::Algorithm preAlgo("");
-    rcube::Algorithm algo("");
-
-    const rcube::Orientation TOP = {Axis::Y, 1};
-    const rcube::Orientation BACK = {Axis::Z, -1};
-    const rcube::Coordinates BACK_LEFT(-1, 1, -1);
-
-    for (AlgoDBItem item : algoDb)
-    {
-        if (item.type != AlgoType::PLL || item.match == "") continue;
-        
-        if (_cube.layerMatches(TOP, item.match, BACK_LEFT, BACK, &preAlgo))
-        {
-            algo = rcube::Algorithm(item.algo);
-            break;
-        }
-    }
+    rcube::Algorithm algo = getPllAlgorithm(_cube.getState());
     _cube.performAlgorithm(algo);
 
-    while (!_cube.isSolved())
-    {
-        _cube.performMove(rcube::Move('U', 1));
-        algo.push(rcube::Move('U', 1));
-    }
-    
-
-    algo = preAlgo + algo;
-    algo.normalize();
-
     if (_verbose)
     {
         std::cout << "[CFOP] PLL: " << algo.to_string() << std::endl;
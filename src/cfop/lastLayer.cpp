@@ -0,0 +1,485 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <stdexcept>
+
+#include <rcube.hpp>
+#include <solving.hpp>
+
+#include "lastLayer.hpp"
+#include "algoDButil.hpp"
+
+extern std::vector<AlgoDBItem> algoDb;
+
+// the top layer slots of rcube::PackedState are the first 4 edges (UR, UF,
+// UL, UB) and the first 4 corners (URF, UFL, ULB, UBR)
+#define N_OLL_KEYS (16 * 81) // 4 edge and 4 corner orientations
+#define N_PLL_KEYS (16 * 16 * 16) // the pieces in 3 edge and 3 corner slots
+
+// The keys are computed after rcube::PackedState::getReoriented, so that
+// pieces are named after the centers they belong to, whatever rotations have
+// been applied to the cube
+
+static int ollKey(const rcube::PackedState &state)
+{
+    int key = 0;
+    for (int i = 3; i >= 0; --i)
+        key = key * 3 + (state.data[rcube::PackedState::CORNERS + i] >> 4);
+    for (int i = 3; i >= 0; --i)
+        key = key * 2 + (state.data[rcube::PackedState::EDGES + i] >> 4);
+    return key;
+}
+
+static int pllKey(const rcube::PackedState &state)
+{
+    // the top layer has to be oriented
+    for (int i = 0; i < 4; ++i)
+    {
+        if (state.data[rcube::PackedState::EDGES + i] > 3) return -1;
+        if (state.data[rcube::PackedState::CORNERS + i] > 3) return -1;
+    }
+
+    // the last piece of each kind is implied by the other three
+    int key = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        key = key * 16 + state.data[rcube::PackedState::EDGES + i] * 4 +
+            state.data[rcube::PackedState::CORNERS + i];
+    }
+    return key;
+}
+
+// the AUF moves, from the most to the least preferred
+static const int aufs[4] = {0, 1, -1, 2};
+
+static rcube::Algorithm auf(int q)
+{
+    rcube::Algorithm res;
+    if (q != 0) res.push(rcube::Move('U', q));
+    return res;
+}
+
+struct LastLayerIndex
+{
+    std::vector<rcube::Algorithm> oll;
+    std::vector<rcube::Algorithm> pll;
+    std::vector<bool> ollFound;
+    std::vector<bool> pllFound;
+
+    LastLayerIndex();
+
+    // Indexes the state solved by algo (the one the inverse of algo brings a
+    // solved cube to), if it has F2L solved and is not indexed yet
+    void add(const rcube::Algorithm &algo, int (*key)(const rcube::PackedState&),
+        std::vector<rcube::Algorithm> &cases, std::vector<bool> &found);
+};
+
+void LastLayerIndex::add(const rcube::Algorithm &algo,
+    int (*key)(const rcube::PackedState&), std::vector<rcube::Algorithm> &cases,
+    std::vector<bool> &found)
+{
+    rcube::PackedState state;
+    state.performAlgorithm(algo.reverse());
+    state = state.getReoriented();
+
+    rcube::PackedState solved;
+    for (int i = 4; i < 12; ++i)
+    {
+        if (state.data[rcube::PackedState::EDGES + i] !=
+            solved.data[rcube::PackedState::EDGES + i]) return;
+    }
+    for (int i = 4; i < 8; ++i)
+    {
+        if (state.data[rcube::PackedState::CORNERS + i] !=
+            solved.data[rcube::PackedState::CORNERS + i]) return;
+    }
+
+    int k = key(state);
+    if (k < 0 || found[k]) return;
+
+    cases[k] = algo;
+    found[k] = true;
+}
+
+LastLayerIndex::LastLayerIndex()
+    : oll(N_OLL_KEYS), pll(N_PLL_KEYS), ollFound(N_OLL_KEYS, false),
+    pllFound(N_PLL_KEYS, false)
+{
+    // skips first, then the algorithms in the same order as algoDb (the first
+    // one that matches a case is the one used)
+    add(rcube::Algorithm(), &ollKey, oll, ollFound);
+    for (int post : aufs) add(auf(post), &pllKey, pll, pllFound);
+
+    for (const AlgoDBItem &item : algoDb)
+    {
+        if (item.match == "") continue;
+
+        rcube::Algorithm algo(item.algo);
+
+        if (item.type == AlgoType::OLL)
+        {
+            for (int pre : aufs)
+                add(auf(pre) + algo, &ollKey, oll, ollFound);
+        }
+        else if (item.type == AlgoType::PLL)
+        {
+            // the fewer AUF moves, the better
+            for (int moves = 0; moves <= 2; ++moves)
+            {
+                for (int pre : aufs)
+                {
+                    for (int post : aufs)
+                    {
+                        if ((pre != 0) + (post != 0) != moves) continue;
+                        add(auf(pre) + algo + auf(post), &pllKey, pll,
+                            pllFound);
+                    }
+                }
+            }
+        }
+    }
+
+    for (rcube::Algorithm &algo : oll) algo.normalize();
+    for (rcube::Algorithm &algo : pll) algo.normalize();
+}
+
+static const LastLayerIndex& getIndex()
+{
+    static const LastLayerIndex index;
+    return index;
+}
+
+const rcube::Algorithm& getOllAlgorithm(const rcube::PackedState &state)
+{
+    return getIndex().oll[ollKey(state.getReoriented())];
+}
+
+const rcube::Algorithm& getPllAlgorithm(const rcube::PackedState &state)
+{
+    static const rcube::Algorithm none;
+
+    int key = pllKey(state.getReoriented());
+    if (key < 0) return none;
+    return getIndex().pll[key];
+}
+
+// One-look last layer: the state of the top layer is the permutation of its
+// edges and corners (4! each) and the orientation of 3 edges and 3 corners
+// (the 4th ones are implied)
+#define N_LL_KEYS (24 * 24 * 8 * 27)
+
+// the first 4 bytes of a table file
+static const char LL_MAGIC[4] = {'R', 'C', 'L', 'L'};
+
+// the moves are stored as their index in this array
+static const rcube::Move llMoves[18] = {
+    rcube::Move('L', 1), rcube::Move('L', 2), rcube::Move('L', -1),
+    rcube::Move('R', 1), rcube::Move('R', 2), rcube::Move('R', -1),
+    rcube::Move('D', 1), rcube::Move('D', 2), rcube::Move('D', -1),
+    rcube::Move('U', 1), rcube::Move('U', 2), rcube::Move('U', -1),
+    rcube::Move('B', 1), rcube::Move('B', 2), rcube::Move('B', -1),
+    rcube::Move('F', 1), rcube::Move('F', 2), rcube::Move('F', -1)
+};
+
+static int permRank(const uint8_t *data)
+{
+    int rank = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        int smaller = 0;
+        for (int k = i + 1; k < 4; ++k)
+            if ((data[k] & 0x0f) < (data[i] & 0x0f)) smaller++;
+        rank = rank * (4 - i) + smaller;
+    }
+    return rank;
+}
+
+static void setPerm(int rank, uint8_t *data)
+{
+    int digits[4];
+    for (int i = 3; i >= 0; --i)
+    {
+        digits[i] = rank % (4 - i);
+        rank /= 4 - i;
+    }
+
+    bool taken[4] = {false};
+    for (int i = 0; i < 4; ++i)
+    {
+        int piece = 0;
+        for (int d = digits[i]; taken[piece] || d > 0; ++piece)
+            if (!taken[piece]) d--;
+
+        taken[piece] = true;
+        data[i] = piece;
+    }
+}
+
+static bool f2lSolved(const rcube::PackedState &state)
+{
+    rcube::PackedState solved;
+    return std::memcmp(state.data + rcube::PackedState::EDGES + 4,
+        solved.data + rcube::PackedState::EDGES + 4, 8) == 0 &&
+        std::memcmp(state.data + rcube::PackedState::CORNERS + 4,
+        solved.data + rcube::PackedState::CORNERS + 4, 4) == 0;
+}
+
+// Returns the key of a reoriented state, -1 if F2L is not solved
+static int lastLayerKey(const rcube::PackedState &state)
+{
+    if (!f2lSolved(state)) return -1;
+
+    const uint8_t *edges = state.data + rcube::PackedState::EDGES;
+    const uint8_t *corners = state.data + rcube::PackedState::CORNERS;
+
+    int key = permRank(edges) * 24 + permRank(corners);
+    for (int i = 2; i >= 0; --i) key = key * 2 + (edges[i] >> 4);
+    for (int i = 2; i >= 0; --i) key = key * 3 + (corners[i] >> 4);
+    return key;
+}
+
+// Returns false if the key does not describe a state that can be reached
+static bool lastLayerState(int key, rcube::PackedState *state)
+{
+    uint8_t *edges = state->data + rcube::PackedState::EDGES;
+    uint8_t *corners = state->data + rcube::PackedState::CORNERS;
+
+    uint8_t eo[4], co[4];
+    co[3] = 0;
+    for (int i = 0; i < 3; ++i, key /= 3)
+    {
+        co[i] = key % 3;
+        co[3] = (co[3] + 2 * co[i]) % 3; // the sum must be a multiple of 3
+    }
+    eo[3] = 0;
+    for (int i = 0; i < 3; ++i, key /= 2)
+    {
+        eo[i] = key % 2;
+        eo[3] ^= eo[i];
+    }
+
+    setPerm(key % 24, corners);
+    setPerm(key / 24, edges);
+
+    // the parity of the edge and corner permutations must be the same
+    int parity = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int k = i + 1; k < 4; ++k)
+            parity ^= (edges[k] < edges[i]) ^ (corners[k] < corners[i]);
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        edges[i] |= eo[i] << 4;
+        corners[i] |= co[i] << 4;
+    }
+    return parity == 0;
+}
+
+// The states that only differ by a U turn before and after them are solved
+// by the same algorithm (with different AUF moves), so only one state out of
+// each group of up to 16 is stored in the files. auf(a, b) applied to a state
+// S is U^b * S * U^a: if X solves it, then U^a + X + U^b solves S.
+static rcube::PackedState withAuf(const rcube::PackedState &state, int a, int b)
+{
+    rcube::PackedState res = rcube::PackedState::getMoveState(
+        rcube::Move('U', b));
+    res.multiply(state);
+    res.multiply(rcube::PackedState::getMoveState(rcube::Move('U', a)));
+    return res;
+}
+
+// The table is replaced as a whole by loadLastLayerTable: the solvers that
+// are running keep a reference to the previous one until they are done
+struct LastLayerTable
+{
+    std::vector<rcube::Algorithm> algos;
+    std::vector<bool> found;
+};
+
+static std::mutex lastLayerMutex;
+static std::shared_ptr<const LastLayerTable> lastLayerTable;
+
+// The integers of the files are stored in little-endian byte order, so that
+// a table can be used on any machine
+
+static void writeUint32(std::ostream &file, uint32_t n)
+{
+    char bytes[4];
+    for (int i = 0; i < 4; ++i) bytes[i] = (n >> (8 * i)) & 0xff;
+    file.write(bytes, 4);
+}
+
+static bool readUint32(std::istream &file, uint32_t *n)
+{
+    unsigned char bytes[4];
+    if (!file.read((char*)bytes, 4)) return false;
+
+    *n = 0;
+    for (int i = 3; i >= 0; --i) *n = (*n << 8) | bytes[i];
+    return true;
+}
+
+void writeLastLayerTable(const std::string &path,
+    const std::vector<std::pair<int, rcube::Algorithm>> &records)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        throw std::invalid_argument("Cannot write to file: " + path);
+
+    file.write(LL_MAGIC, 4);
+    writeUint32(file, records.size());
+
+    for (const auto &record : records)
+    {
+        // record: key (4 bytes), length (1 byte), one byte per move
+        uint8_t length = record.second.length();
+        writeUint32(file, record.first);
+        file.write((char*)&length, 1);
+
+        for (const rcube::Move &move : record.second.algorithm)
+        {
+            uint8_t idx = 0;
+            while (idx < 18 && llMoves[idx] != move) idx++;
+            if (idx == 18)
+                throw std::invalid_argument("Unsupported move: " +
+                    move.to_string());
+            file.write((char*)&idx, 1);
+        }
+    }
+}
+
+int getLastLayerKey(const rcube::PackedState &state)
+{
+    return lastLayerKey(state.getReoriented());
+}
+
+void CfopSolver::generateLastLayerTable(const std::string &path,
+    bool edgesOriented, int threads, int timeout)
+{
+    std::vector<bool> done(N_LL_KEYS, false);
+    std::vector<int> keys;
+
+    for (int key = 0; key < N_LL_KEYS; ++key)
+    {
+        rcube::PackedState state;
+        if (done[key] || !lastLayerState(key, &state)) continue;
+        if (edgesOriented && (key / 27) % 8 != 0) continue;
+
+        for (int a = 0; a < 4; ++a)
+            for (int b = 0; b < 4; ++b)
+                done[lastLayerKey(withAuf(state, a, b))] = true;
+        keys.push_back(key);
+    }
+
+    std::vector<std::pair<int, rcube::Algorithm>> records;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        rcube::PackedState state;
+        lastLayerState(keys[i], &state);
+
+        // the solved state is the only one that is not given to the solver
+        rcube::Algorithm algo;
+        if (state != rcube::PackedState())
+        {
+            rcube::Cube cube;
+            cube.performAlgorithm(state);
+
+            KociembaSolver solver(cube, threads, timeout);
+            solver.setVerbose(false);
+            algo = solver.solve();
+        }
+        records.push_back({keys[i], algo});
+
+        if ((i + 1) % 100 == 0 || i + 1 == keys.size())
+        {
+            std::cout << "[CFOP] Last layer cases: " << i + 1 << "/" <<
+                keys.size() << std::endl;
+        }
+    }
+
+    writeLastLayerTable(path, records);
+}
+
+bool CfopSolver::loadLastLayerTable(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    char magic[4];
+    uint32_t count;
+
+    if (!file.read(magic, 4) || std::memcmp(magic, LL_MAGIC, 4) != 0 ||
+        !readUint32(file, &count)) return false;
+
+    auto table = std::make_shared<LastLayerTable>();
+    table->algos.resize(N_LL_KEYS);
+    table->found.resize(N_LL_KEYS, false);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t key;
+        uint8_t length, moves[255];
+        if (!readUint32(file, &key) || !file.read((char*)&length, 1) ||
+            !file.read((char*)moves, length) || key >= N_LL_KEYS) return false;
+
+        rcube::Algorithm algo;
+        for (int m = 0; m < length; ++m)
+        {
+            if (moves[m] >= 18) return false;
+            algo.push(llMoves[moves[m]]);
+        }
+
+        // every state of the group gets its own algorithm, with the AUF moves
+        // already added
+        rcube::PackedState state;
+        if (!lastLayerState(key, &state)) return false;
+
+        for (int a : aufs)
+        {
+            for (int b : aufs)
+            {
+                int k = lastLayerKey(withAuf(state, -a, -b));
+                rcube::Algorithm res = auf(a) + algo + auf(b);
+                res.normalize();
+
+                if (table->found[k] && table->algos[k].length() <=
+                    res.length()) continue;
+                table->algos[k] = res;
+                table->found[k] = true;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(lastLayerMutex);
+    lastLayerTable = std::move(table);
+    return true;
+}
+
+bool getLastLayerAlgorithm(const rcube::PackedState &state,
+    rcube::Algorithm *dest)
+{
+    std::shared_ptr<const LastLayerTable> table;
+    {
+        std::lock_guard<std::mutex> lock(lastLayerMutex);
+        table = lastLayerTable;
+    }
+    if (table == nullptr) return false;
+
+    int key = lastLayerKey(state.getReoriented());
+    if (key < 0 || !table->found[key]) return false;
+
+    *dest = table->algos[key];
+    return true;
+}
@@ -0,0 +1,48 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <rcube.hpp>
+
+// Last layer case recognition. The OLL and PLL algorithms of algoDb are
+// indexed (the first time one of these functions is called) by the state they
+// solve: the orientation of the 4 edges and 4 corners of the top layer for
+// OLL, their permutation for PLL. Each index entry already contains the AUF
+// moves needed before (and, for PLL, after) the algorithm, so recognizing a
+// case is a single array lookup.
+// The cube is expected to have F2L solved, with the last layer on top; an
+// empty algorithm is returned if the state is not indexed.
+
+// Returns the algorithm (AUF + OLL) that orients the last layer
+const rcube::Algorithm& getOllAlgorithm(const rcube::PackedState &state);
+
+// Returns the algorithm (AUF + PLL + AUF) that solves an oriented last layer
+const rcube::Algorithm& getPllAlgorithm(const rcube::PackedState &state);
+
+// Copies into dest the algorithm (AUF + algorithm + AUF) that solves the whole
+// last layer in one look. Returns false if no table has been loaded (see
+// CfopSolver::loadLastLayerTable) or the state is not in it. This is safe
+// while another thread loads a table
+bool getLastLayerAlgorithm(const rcube::PackedState &state,
+    rcube::Algorithm *dest);
+
+// Returns the key of a last layer state in the tables, -1 if F2L is not solved
+int getLastLayerKey(const rcube::PackedState &state);
+
+// Writes a table file with the given records (key, algorithm). The file starts
+// with "RCLL" and the number of records, then each record holds the key (4
+// bytes), the length of the algorithm (1 byte) and one byte per move. The
+// integers are little-endian, whatever the byte order of the machine
+void writeLastLayerTable(const std::string &path,
+    const std::vector<std::pair<int, rcube::Algorithm>> &records);
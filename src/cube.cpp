@@ -25,6 +25,8 @@ using pairOrientColor = std::pair<rcube::Orientation, Color>;
 
 rcube::Center* rcube::Cube::getCenterFrom(const Color &color)
 {
+    updateBlocks();
+
     for (int i = 0; i < 6; ++i)
     {
         if (centers[i].color == color) return centers + i;
@@ -34,6 +36,8 @@ rcube::Center* rcube::Cube::getCenterFrom(const Color &color)
 
 rcube::Center* rcube::Cube::getCenterFrom(const rcube::Coordinates &coords)
 {
+    updateBlocks();
+
     for (int i = 0; i < 6; ++i)
     {
         if (centers[i].location == coords) return centers + i;
@@ -43,6 +47,8 @@ rcube::Center* rcube::Cube::getCenterFrom(const rcube::Coordinates &coords)
 
 rcube::Center* rcube::Cube::getCenterFrom(const rcube::Orientation &orient)
 {
+    updateBlocks();
+
     for (int i = 0; i < 6; ++i)
     {
         if (centers[i].orientation == orient) return centers + i;
@@ -69,7 +75,7 @@ void rcube::Cube::display ()
     rcube::Net toDisplay = netRender();
     for (rcube::Orientation o : rcube::Orientation::iterate())
     {
-        std::cout << "\nFace at orientation (" << o.axis << "; " <<
+        std::cout << "\nFace at orientation (" << (int)o.axis << "; " <<
             o.direction << "):" << std::endl;
 
         for (int y = 1; y >= -1; --y)
@@ -86,21 +92,58 @@ void rcube::Cube::display ()
 
 rcube::Cube::Cube(const Color& topColor, const Color& frontColor)
 {
-    // centers, edges and corners are first initialized in the default position
-    // (top: white, front: green), then the cube is rotated until the desired
-    // position is reached
+    // the cube is first initialized in the default position (top: white,
+    // front: green), then it is rotated until the desired position is reached
 
-    std::vector<rcube::Orientation> orients = rcube::Orientation::iterate();
     char defaultColors[] = {'o', 'r', 'y', 'w', 'b', 'g'};
 
-    for (int i = 0; i < 6; ++i)
+    for (int i = 0; i < 6; ++i) centers[i].color = (Color)defaultColors[i];
+    blocksOutdated = true;
+    hash = state.getHash();
+
+    rotateTo(topColor, frontColor);
+}
+
+// The order of the pieces in the edges and corners arrays (and of the
+// stickers of each piece), which the functions that scan the arrays (like
+// the matchers used by the CFOP solver) depend on. It is the order in which
+// the blocks of a solved cube with the default colors are listed: for each
+// face among L, R, D and U, the edges and corners between it and the F and B
+// faces, then the edge that joins it to the next face.
+struct BlockOrder
+{
+    int edgeIdx[12];        // index in the edges array of each edge
+    int edgeSticker[12][2]; // edgeFaces index of each sticker in the array
+    int cornerIdx[8];
+    int cornerSticker[8][3];
+
+    BlockOrder();
+};
+
+template<int N>
+static int findPiece(const rcube::Orientation (*pieceFaces)[N], int nPieces,
+    const rcube::Orientation *faces, int *stickers)
+{
+    for (int p = 0; p < nPieces; ++p)
     {
-        centers[i] = rcube::Center((Color)defaultColors[i], orients[i]);
+        int found = 0;
+        for (int j = 0; j < N; ++j)
+        {
+            for (int k = 0; k < N; ++k)
+            {
+                if (pieceFaces[p][k] != faces[j]) continue;
+                stickers[j] = k;
+                found++;
+            }
+        }
+        if (found == N) return p;
     }
+    return -1;
+}
 
-    // initialize edges and corners
-    int eIdx = 0; // index in edges array
-    int cIdx = 0; // index in corner array
+BlockOrder::BlockOrder()
+{
+    int eIdx = 0, cIdx = 0;
     rcube::Orientation o[3];
 
     for (int a1 = 0, d1 = -1; a1 < 2; d1 *= -1)
@@ -112,146 +155,199 @@ rcube::Cube::Cube(const Color& topColor, const Color& frontColor)
         {
             o[1] = {Axis::Z, d2};
 
-            edges[eIdx].location = rcube::Coordinates(o[0], o[1]);
-            for (int i = 0; i <= 1; ++i)
-            {
-                edges[eIdx].stickers[i] = {
-                    getCenterFrom(rcube::Coordinates(o[i]))->color, o[i]};
-            }
+            int p = findPiece<2>(rcube::PackedState::edgeFaces, 12, o,
+                edgeSticker[eIdx]);
+            edgeIdx[p] = eIdx++;
 
-            corners[cIdx].location = rcube::Coordinates(o[0], o[1], o[2]);
-            for (int i = 0; i <= 1; ++i)
-                corners[cIdx].stickers[i] = edges[eIdx].stickers[i];
-            corners[cIdx].stickers[2] = {
-                getCenterFrom(rcube::Coordinates(o[2]))->color, o[2]};
-            cIdx++;
-            eIdx++;
+            p = findPiece<3>(rcube::PackedState::cornerFaces, 8, o,
+                cornerSticker[cIdx]);
+            cornerIdx[p] = cIdx++;
         }
 
-        edges[eIdx].location = rcube::Coordinates(o[0], o[2]);
-        for (int i = 0; i <= 1; ++i)
-        {
-            edges[eIdx].stickers[i] = {
-                getCenterFrom(rcube::Coordinates(o[i*2]))->color, o[i*2]};
-        }
-        eIdx++;
+        rcube::Orientation faces[2] = {o[0], o[2]};
+        int p = findPiece<2>(rcube::PackedState::edgeFaces, 12, faces,
+            edgeSticker[eIdx]);
+        edgeIdx[p] = eIdx++;
 
         if (d1 == 1) a1++;
     }
+}
 
-    rotateTo(topColor, frontColor);
+static const BlockOrder& getBlockOrder()
+{
+    static const BlockOrder order;
+    return order;
 }
 
-void rcube::Cube::performMove (const rcube::Move& move)
+void rcube::Cube::updateBlocks()
 {
-    switch (move.face)
+    if (!blocksOutdated) return;
+
+    // Each piece is identified by the slot it occupies when the cube is solved
+    // (see rcube::PackedState), so its colors are the ones of the centers of
+    // the faces adjacent to that slot. Centers are numbered after the face they
+    // belong to.
+
+    std::vector<rcube::Orientation> faces = rcube::Orientation::iterate();
+    Color colors[6];
+    for (int i = 0; i < 6; ++i) colors[i] = centers[i].color;
+
+    for (int s = 0; s < 6; ++s)
+    {
+        int c = state.data[rcube::PackedState::CENTERS + s] - 8;
+        centers[c] = rcube::Center(colors[c], faces[s]);
+    }
+
+    const BlockOrder &order = getBlockOrder();
+
+    for (int s = 0; s < 12; ++s)
     {
-        case UP:
-        case FRONT:
-        case RIGHT:
-        case LEFT:
-        case DOWN:
-        case BACK:
-            rotateLayer(move); return;
-
-        case UP_W:
-        case FRONT_W:
-        case RIGHT_W:
-        case LEFT_W:
-        case DOWN_W:
-        case BACK_W:
+        uint8_t val = state.data[rcube::PackedState::EDGES + s];
+        int p = val & 0x0f;
+        rcube::Edge *e = edges + order.edgeIdx[p];
+        const rcube::Orientation *slotFaces = rcube::PackedState::edgeFaces[s];
+        const rcube::Orientation *homeFaces = rcube::PackedState::edgeFaces[p];
+
+        e->location = rcube::Coordinates(slotFaces[0], slotFaces[1]);
+        for (int j = 0; j < 2; ++j)
         {
-            std::map<MoveFace, std::string> algos = {
-                {UP_W, "Dy"},
-                {FRONT_W, "Bz"},
-                {RIGHT_W, "Lx"},
-                {LEFT_W, "Rx'"},
-                {DOWN_W, "Uy'"},
-                {BACK_W, "Fz'"}
+            int k = order.edgeSticker[order.edgeIdx[p]][j];
+            e->stickers[j] = {
+                colors[rcube::PackedState::faceIndex(homeFaces[k])],
+                slotFaces[(k + (val >> 4)) % 2]
             };
-
-            rcube::Algorithm algo(algos[move.face]);
-            performAlgorithm(algo * move.direction);
-            return;
         }
 
-        case ROTATE_X:
-        case ROTATE_Y:
-        case ROTATE_Z:
-            changeViewpoint(move); return;
+        if (s >= 8) continue;
+
+        val = state.data[rcube::PackedState::CORNERS + s];
+        p = val & 0x0f;
+        rcube::Corner *c = corners + order.cornerIdx[p];
+        slotFaces = rcube::PackedState::cornerFaces[s];
+        homeFaces = rcube::PackedState::cornerFaces[p];
 
-        case MIDDLE:
-        case EQUATOR:
-        case SIDE:
+        c->location = rcube::Coordinates(slotFaces[0], slotFaces[1],
+            slotFaces[2]);
+        for (int j = 0; j < 3; ++j)
         {
-            std::map<MoveFace, std::string> algos = {
-                {MIDDLE, "RL'x'"},
-                {EQUATOR, "UD'y'"},
-                {SIDE, "F'Bz"}
+            int k = order.cornerSticker[order.cornerIdx[p]][j];
+            c->stickers[j] = {
+                colors[rcube::PackedState::faceIndex(homeFaces[k])],
+                slotFaces[(k + (val >> 4)) % 3]
             };
-
-            rcube::Algorithm algo(algos[move.face]);
-            performAlgorithm(algo * move.direction);
-            return;
         }
     }
+
+    blocksOutdated = false;
 }
 
-void rcube::Cube::changeViewpoint (const rcube::Move& move)
+template<int N, typename T>
+uint8_t packBlock(T *blocks, int nBlocks, int slot,
+    const rcube::Orientation (*slotFaces)[N], const rcube::Center *centers)
 {
-    for (int i = 0; i < 12; ++i)
+    // Returns the byte of a rcube::PackedState that describes the block placed
+    // in the given slot
+
+    rcube::Coordinates pos(0, 0, 0);
+    for (int k = 0; k < N; ++k)
+        pos.coords[slotFaces[slot][k].axis] = slotFaces[slot][k].direction;
+
+    for (int i = 0; i < nBlocks; ++i)
     {
-        edges[i].location.rotate(move.axis, move.direction);
-        for (int k = 0; k < 2; ++k)
+        if (blocks[i].location != pos) continue;
+
+        // the faces that the block's stickers belong to when it is solved
+        rcube::Orientation home[N];
+        for (int k = 0; k < N; ++k)
         {
-            edges[i].stickers[k].orientation.rotate(move.axis, move.direction);
+            for (int x = 0; x < N; ++x)
+            {
+                if (blocks[i].stickers[x].orientation != slotFaces[slot][k])
+                    continue;
+
+                for (int c = 0; c < 6; ++c)
+                {
+                    if (centers[c].color == blocks[i].stickers[x].color)
+                        home[k] = centers[c].orientation;
+                }
+            }
         }
 
-        if (i >= 8) continue;
-
-        corners[i].location.rotate(move.axis, move.direction);
-        for (int k = 0; k < 3; ++k)
+        for (int p = 0; p < nBlocks; ++p)
         {
-            corners[i].stickers[k].orientation.rotate(move.axis, move.direction);
-        }
+            for (int ori = 0; ori < N; ++ori)
+            {
+                int k = 0;
+                while (k < N && home[(k + ori) % N] == slotFaces[p][k]) ++k;
 
-        if (i >= 6) continue;
-        centers[i].location.rotate(move.axis, move.direction);
-        centers[i].orientation.rotate(move.axis, move.direction);
+                if (k == N) return p | (ori << 4);
+            }
+        }
+        break;
     }
+    throw std::invalid_argument("Invalid block at " + pos.to_string());
 }
 
-void rcube::Cube::rotateLayer(const rcube::Move& move)
+void rcube::Cube::packBlocks()
 {
-    rcube::Orientation o = move.getAffectedFace();
-    int step = o.direction * move.direction;
+    // centers are renumbered after the face they are on
+    rcube::Center tmp[6];
+    for (int i = 0; i < 6; ++i)
+    {
+        tmp[rcube::PackedState::faceIndex(centers[i].orientation)] = centers[i];
+    }
 
-    for (int i = 0; i < 12; ++i)
+    state = rcube::PackedState();
+    for (int i = 0; i < 6; ++i) centers[i] = tmp[i];
+
+    for (int s = 0; s < 12; ++s)
     {
-        if (edges[i].location.coords[o.axis] == o.direction)
-        {
-            edges[i].location.rotate(o.axis, step);
-            for (int k = 0; k < 2; ++k)
-            {
-                if (edges[i].stickers[k].orientation == o) continue;
+        state.data[rcube::PackedState::EDGES + s] = packBlock<2>(edges, 12, s,
+            rcube::PackedState::edgeFaces, centers);
 
-                edges[i].stickers[k].orientation.rotate(o.axis, step);
-            }
-        }
+        if (s >= 8) continue;
 
-        if (i >=8) continue;
+        state.data[rcube::PackedState::CORNERS + s] = packBlock<3>(corners, 8,
+            s, rcube::PackedState::cornerFaces, centers);
+    }
 
-        if (corners[i].location.coords[o.axis] == o.direction)
-        {
-            corners[i].location.rotate(o.axis, step);
-            for (int k = 0; k < 3; ++k)
-            {
-                if (corners[i].stickers[k].orientation == o) continue; 
+    // If the colors are the default ones seen from another viewpoint, the
+    // pieces are renamed after the default colors so that equal cubes have
+    // equal states: the state becomes the rotation that brings the default
+    // colors to the current faces, followed by the current permutation.
+    rcube::Cube ref(centers[3].color, centers[5].color);
+    ref.updateBlocks();
 
-                corners[i].stickers[k].orientation.rotate(o.axis, step);
-            }
-        }
+    bool sameScheme = true;
+    for (int i = 0; i < 6; ++i)
+    {
+        if (ref.getCenterFrom(centers[i].orientation)->color != centers[i].color)
+            sameScheme = false;
+    }
+
+    if (sameScheme)
+    {
+        rcube::PackedState pieces = state;
+        state = ref.state;
+        state.multiply(pieces);
+        for (int i = 0; i < 6; ++i) centers[i].color = ref.centers[i].color;
     }
+
+    hash = state.getHash();
+    blocksOutdated = true;
+}
+
+void rcube::Cube::performMove (const rcube::Move& move)
+{
+    // every move (layers, slices, wide moves and rotations) is precomputed
+    uint32_t moved = rcube::PackedState::getMovedSlots(move);
+    if (moved == 0) return;
+
+    hash ^= state.getHash(moved);
+    state.performMove(move);
+    hash ^= state.getHash(moved);
+
+    blocksOutdated = true;
 }
 
 void rcube::Cube::performAlgorithm (const rcube::Algorithm& algorithm)
@@ -265,6 +361,13 @@ void rcube::Cube::performAlgorithm (const std::string &algorithm)
     performAlgorithm(rcube::Algorithm(algorithm));
 }
 
+void rcube::Cube::performAlgorithm (const rcube::PackedState &compiled)
+{
+    state.multiply(compiled);
+    hash = state.getHash();
+    blocksOutdated = true;
+}
+
 void rcube::Cube::scramble(const int &length, rcube::Algorithm* dest)
 {
     rcube::Algorithm scramble = rcube::Algorithm::generateScramble(length);
@@ -274,29 +377,7 @@ void rcube::Cube::scramble(const int &length, rcube::Algorithm* dest)
 
 bool rcube::Cube::isSolved()
 {
-    for (int i = 0; i < 12; ++i)
-    {
-        for (int k = 0; k < 2; ++k)
-        {
-            if (edges[i].stickers[k].color !=
-                getCenterFrom(edges[i].stickers[k].orientation)->color)
-            {
-                return false;
-            }
-        }
-
-        if (i >= 8) continue;
-
-        for (int k = 0; k < 3; ++k)
-        {
-            if (corners[i].stickers[k].color !=
-                getCenterFrom(corners[i].stickers[k].orientation)->color)
-            {
-                return false;
-            }
-        }
-    }
-    return true;
+    return state.isSolved();
 }
 
 bool areAdjacentColors(Color c1, Color c2)
@@ -317,6 +398,8 @@ bool areAdjacentColors(Color c1, Color c2)
 
 bool rcube::Cube::isSolvable()
 {
+    updateBlocks();
+
     try
     {
         if (getCenterFrom(Color::White)->orientation !=
@@ -391,6 +474,8 @@ rcube::Algorithm rcube::Cube::rotateTo(const Color &topColor,
 
 rcube::Net rcube::Cube::netRender()
 {
+    updateBlocks();
+
     rcube::Net net; // to return
 
     for (int i = 0; i < 6; ++i)
@@ -446,6 +531,8 @@ rcube::Net rcube::Cube::netRender()
 
 rcube::BlockArray rcube::Cube::blockRender()
 {
+    updateBlocks();
+
     rcube::BlockArray pattern; // to return
     
     int patternIndex = 0;
@@ -501,6 +588,15 @@ rcube::Algorithm rcube::Cube::solveCfop(bool verbose, Color crossColor)
     return solution;
 }
 
+rcube::Algorithm rcube::Cube::solveCfopColorNeutral(bool verbose)
+{
+    CfopSolver solver(*this, Color::White, verbose);
+    rcube::Algorithm solution = solver.solveColorNeutral();
+    performAlgorithm(solution);
+
+    return solution;
+}
+
 rcube::Algorithm rcube::Cube::solveKociemba()
 {
     KociembaSolver solver(*this);
@@ -517,4 +613,31 @@ rcube::Algorithm rcube::Cube::solveKociemba(int threads, int timeout)
     performAlgorithm(solution);
 
     return solution;
+}
+
+const rcube::PackedState& rcube::Cube::getState() const
+{
+    return state;
+}
+
+uint64_t rcube::Cube::getHash() const
+{
+    return hash;
+}
+
+bool rcube::Cube::operator==(const rcube::Cube &c) const
+{
+    if (hash != c.hash || state != c.state) return false;
+
+    // only differs for cubes initialized with unusual color schemes
+    for (int i = 0; i < 6; ++i)
+    {
+        if (centers[i].color != c.centers[i].color) return false;
+    }
+    return true;
+}
+
+bool rcube::Cube::operator!=(const rcube::Cube &c) const
+{
+    return !(*this == c);
 }
\ No newline at end of file
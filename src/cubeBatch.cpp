@@ -0,0 +1,268 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+#include <rcube.hpp>
+
+// bytes of the rows that are actually used (see rcube::PackedState)
+#define USED_SLOTS 0x3fff0fff
+
+static void moveRow(uint8_t *dest, const uint8_t *src, int len, uint8_t ori,
+    bool isEdge)
+{
+    // dest[i] = src[i] + ori, with the orientation reduced modulo 2 for edges
+    // and modulo 3 for corners (see rcube::PackedState::multiply). len is a
+    // multiple of 32.
+
+    int i = 0;
+
+#if defined(__AVX2__)
+    const __m256i vOri = _mm256_set1_epi8(ori);
+    const __m256i edgeMask = _mm256_set1_epi8(0x1f);
+    const __m256i cornerMod = _mm256_set1_epi8(0x30);
+
+    for (; i < len; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        v = _mm256_add_epi8(v, vOri);
+        if (isEdge) v = _mm256_and_si256(v, edgeMask);
+        else v = _mm256_min_epu8(v, _mm256_sub_epi8(v, cornerMod));
+        _mm256_storeu_si256((__m256i*)(dest + i), v);
+    }
+
+#elif defined(__SSSE3__)
+    const __m128i vOri = _mm_set1_epi8(ori);
+    const __m128i edgeMask = _mm_set1_epi8(0x1f);
+    const __m128i cornerMod = _mm_set1_epi8(0x30);
+
+    for (; i < len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        v = _mm_add_epi8(v, vOri);
+        if (isEdge) v = _mm_and_si128(v, edgeMask);
+        else v = _mm_min_epu8(v, _mm_sub_epi8(v, cornerMod));
+        _mm_storeu_si128((__m128i*)(dest + i), v);
+    }
+#endif
+
+    for (; i < len; ++i)
+    {
+        uint8_t v = src[i] + ori;
+        if (isEdge) dest[i] = v & 0x1f;
+        else dest[i] = (v >= 0x30) ? v - 0x30 : v;
+    }
+}
+
+rcube::CubeBatch::CubeBatch(int size) : n(0), capacity(0)
+{
+    reserve(size);
+    n = size;
+}
+
+void rcube::CubeBatch::reserve(int size)
+{
+    if (size <= capacity) return;
+
+    int newCapacity = (capacity == 0) ? 32 : capacity;
+    while (newCapacity < size) newCapacity *= 2;
+
+    // the new cubes (and the padding) are solved
+    std::vector<uint8_t> newData(32 * newCapacity);
+    for (int s = 0; s < 32; ++s)
+    {
+        uint8_t *row = newData.data() + s * newCapacity;
+        std::memset(row, s % 16, newCapacity);
+        if (n > 0) std::memcpy(row, data.data() + s * capacity, n);
+    }
+
+    data.swap(newData);
+    tmp.resize(32 * newCapacity);
+    capacity = newCapacity;
+}
+
+int rcube::CubeBatch::size() const
+{
+    return n;
+}
+
+void rcube::CubeBatch::push(const rcube::PackedState &state)
+{
+    reserve(n + 1);
+    n++;
+    set(n - 1, state);
+}
+
+void rcube::CubeBatch::push(const rcube::Cube &cube)
+{
+    push(cube.getState());
+}
+
+rcube::PackedState rcube::CubeBatch::get(int idx) const
+{
+    if (idx < 0 || idx >= n)
+        throw std::invalid_argument("Index out of range: " + std::to_string(idx));
+
+    rcube::PackedState res;
+    for (int s = 0; s < 32; ++s) res.data[s] = data[s * capacity + idx];
+    return res;
+}
+
+void rcube::CubeBatch::set(int idx, const rcube::PackedState &state)
+{
+    if (idx < 0 || idx >= n)
+        throw std::invalid_argument("Index out of range: " + std::to_string(idx));
+
+    for (int s = 0; s < 32; ++s) data[s * capacity + idx] = state.data[s];
+}
+
+void rcube::CubeBatch::multiply(const rcube::PackedState &t)
+{
+    // the row of slot s is replaced by the row of the slot t takes its piece
+    // from, plus the orientation
+    int len = (n + 31) / 32 * 32;
+
+    for (int s = 0; s < 32; ++s)
+    {
+        if (!((USED_SLOTS >> s) & 1)) continue;
+
+        int lane = s & 0x10;
+        int from = lane + (t.data[s] & 0x0f);
+
+        moveRow(tmp.data() + s * capacity, data.data() + from * capacity, len,
+            t.data[s] & 0x30, lane == rcube::PackedState::EDGES);
+    }
+
+    // the unused rows never change
+    for (int s = 0; s < 32; ++s)
+    {
+        if ((USED_SLOTS >> s) & 1) continue;
+        std::memcpy(tmp.data() + s * capacity, data.data() + s * capacity, len);
+    }
+
+    data.swap(tmp);
+}
+
+void rcube::CubeBatch::performMove(const rcube::Move &move)
+{
+    multiply(rcube::PackedState::getMoveState(move));
+}
+
+void rcube::CubeBatch::performAlgorithm(const rcube::Algorithm &algo)
+{
+    rcube::PackedState combined;
+    combined.performAlgorithm(algo);
+    multiply(combined);
+}
+
+void rcube::CubeBatch::performAlgorithm(const std::string &algo)
+{
+    performAlgorithm(rcube::Algorithm(algo));
+}
+
+std::vector<bool> rcube::CubeBatch::isSolved() const
+{
+    // cubes with the centers in their slots are solved when every row holds
+    // its own slot: this is checked row by row
+    std::vector<uint8_t> identity(n, 1);
+
+    for (int s = 0; s < 32; ++s)
+    {
+        if (!((USED_SLOTS >> s) & 1)) continue;
+
+        const uint8_t *row = data.data() + s * capacity;
+        for (int i = 0; i < n; ++i) identity[i] &= (row[i] == s % 16);
+    }
+
+    // the others (rotated cubes) are checked one by one
+    const uint8_t *uRow = data.data() + (rcube::PackedState::CENTERS + 3) *
+        capacity;
+    const uint8_t *fRow = data.data() + (rcube::PackedState::CENTERS + 5) *
+        capacity;
+
+    std::vector<bool> res(n);
+    for (int i = 0; i < n; ++i)
+    {
+        if (uRow[i] == 11 && fRow[i] == 13) res[i] = identity[i];
+        else res[i] = get(i).isSolved();
+    }
+    return res;
+}
+
+int rcube::CubeBatch::countSolved() const
+{
+    int count = 0;
+    for (bool solved : isSolved()) count += solved;
+    return count;
+}
+
+std::vector<uint16_t> rcube::CubeBatch::getTwist() const
+{
+    // digits in base 3 of the orientations of the first 7 corners
+    std::vector<uint16_t> res(n, 0);
+
+    for (int s = 0; s < 7; ++s)
+    {
+        const uint8_t *row = data.data() + (rcube::PackedState::CORNERS + s) *
+            capacity;
+        for (int i = 0; i < n; ++i) res[i] = res[i] * 3 + (row[i] >> 4);
+    }
+    return res;
+}
+
+std::vector<uint16_t> rcube::CubeBatch::getFlip() const
+{
+    // digits in base 2 of the orientations of the first 11 edges
+    std::vector<uint16_t> res(n, 0);
+
+    for (int s = 0; s < 11; ++s)
+    {
+        const uint8_t *row = data.data() + (rcube::PackedState::EDGES + s) *
+            capacity;
+        for (int i = 0; i < n; ++i) res[i] = res[i] * 2 + (row[i] >> 4);
+    }
+    return res;
+}
+
+std::vector<uint16_t> rcube::CubeBatch::getSlice() const
+{
+    // Same as Kociemba::CubieCube::getSliceSorted() / 24: the slots are read
+    // backwards and the k-th slice edge found in slot s adds (11 - s choose k)
+    static const uint16_t choose[12][5] = {
+        {1, 0, 0, 0, 0}, {1, 1, 0, 0, 0}, {1, 2, 1, 0, 0}, {1, 3, 3, 1, 0},
+        {1, 4, 6, 4, 1}, {1, 5, 10, 10, 5}, {1, 6, 15, 20, 15},
+        {1, 7, 21, 35, 35}, {1, 8, 28, 56, 70}, {1, 9, 36, 84, 126},
+        {1, 10, 45, 120, 210}, {1, 11, 55, 165, 330}
+    };
+
+    std::vector<uint16_t> res(n, 0);
+    std::vector<uint8_t> found(n, 0);
+
+    for (int s = 11; s >= 0; --s)
+    {
+        const uint8_t *row = data.data() + (rcube::PackedState::EDGES + s) *
+            capacity;
+        for (int i = 0; i < n; ++i)
+        {
+            if ((row[i] & 0x0f) < 8) continue;
+
+            found[i]++;
+            res[i] += choose[11 - s][found[i]];
+        }
+    }
+    return res;
+}
@@ -14,6 +14,8 @@
 
 rcube::Coordinates rcube::Cube::find(const Color& c1)
 {
+    updateBlocks();
+
     for (int i = 0; i < 6; ++i)
     {
         if (centers[i].color == c1) return centers[i].location;
@@ -22,6 +24,8 @@ rcube::Coordinates rcube::Cube::find(const Color& c1)
 
 rcube::Coordinates rcube::Cube::find(const Color& c1, const Color &c2)
 {
+    updateBlocks();
+
     for (int i = 0; i < 12; ++i)
     {
         for (int k = 0; k < 2; ++k)
@@ -39,6 +43,8 @@ rcube::Coordinates rcube::Cube::find(const Color& c1, const Color &c2)
 rcube::Coordinates rcube::Cube::find(const Color& c1, const Color &c2,
     const Color &c3)
 {
+    updateBlocks();
+
     for (int i = 0; i < 8; ++i)
     {
         for (int k = 0; k < 3; ++k)
@@ -58,6 +64,8 @@ rcube::Coordinates rcube::Cube::find(const Color& c1, const Color &c2,
 rcube::Orientation rcube::Cube::getStickerOrientation(const rcube::Coordinates
     &coords, const Color &color)
 {
+    updateBlocks();
+
     int blockType = abs(coords.x()) + abs(coords.y()) + abs(coords.z());
 
     if (blockType == 3) // corner
@@ -116,6 +124,8 @@ rcube::Orientation rcube::Cube::getFaceOrientation(const Color &color)
 Color rcube::Cube::getStickerAt(const rcube::Coordinates &coords,
         const rcube::Orientation &orient)
 {
+    updateBlocks();
+
     int blockType = abs(coords.x()) + abs(coords.y()) + abs(coords.z());
 
     if (blockType == 3) // corner
@@ -0,0 +1,196 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#include <vector>
+#include <mutex>
+
+#include "cross.hpp"
+#include "lookupTables.hpp"
+
+extern std::vector<rcube::Move> ph1Moves;
+
+namespace Kociemba
+{
+
+signed char crossPrun[N_CROSS / 2] = {0};
+
+uint8_t edgeMove[24][N_MOVE];
+
+static const Edge crossEdges[4] = {DR, DF, DL, DB};
+
+// slots are counted starting from DR, so that the solved cross is 0
+static int crossSlot(int slot) { return (slot + 12 - DR) % 12; }
+
+int getCross(const uint8_t edges[4])
+{
+    // the slots are ranked among those not taken by the previous edges
+    int slots = 0, flips = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        int slot = crossSlot(edges[i] / 2);
+        for (int k = 0; k < i; ++k)
+            if (crossSlot(edges[k] / 2) < crossSlot(edges[i] / 2)) slot--;
+
+        slots = slots * (12 - i) + slot;
+        flips = flips * 2 + edges[i] % 2;
+    }
+    return slots * 16 + flips;
+}
+
+static void setCross(int cross, uint8_t edges[4])
+{
+    int flips = cross % 16;
+    int slots = cross / 16;
+
+    int ranks[4];
+    for (int i = 3; i >= 0; --i)
+    {
+        ranks[i] = slots % (12 - i);
+        slots /= 12 - i;
+    }
+
+    bool taken[12] = {false};
+    for (int i = 0; i < 4; ++i)
+    {
+        int slot = 0;
+        for (int r = ranks[i]; taken[slot] || r > 0; ++slot)
+            if (!taken[slot]) r--;
+
+        taken[slot] = true;
+        edges[i] = (slot + DR) % 12 * 2 + ((flips >> (3 - i)) & 1);
+    }
+}
+
+int getCross(const CubieCube &cc)
+{
+    uint8_t edges[4];
+    for (int slot = 0; slot < 12; ++slot)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            if (cc.ePerm[slot] == crossEdges[i])
+                edges[i] = slot * 2 + cc.eOri[slot];
+        }
+    }
+    return getCross(edges);
+}
+
+static void generateEdgeMove()
+{
+    CubieCube cube = CubieCube();
+    auto orients = rcube::Orientation::iterate();
+
+    for (int k = 0; k < 6; ++k)
+    {
+        rcube::Move mv(orients[k], 1);
+
+        for (int j = 0; j < 3; ++j)
+        {
+            cube.edgeMultiply(mv);
+
+            // the edge in slot cube.ePerm[i] moves to slot i
+            for (int i = 0; i < 12; ++i)
+            {
+                for (int ori = 0; ori < 2; ++ori)
+                {
+                    edgeMove[cube.ePerm[i] * 2 + ori][3 * k + j] =
+                        i * 2 + (ori ^ cube.eOri[i]);
+                }
+            }
+        }
+        cube.edgeMultiply(mv); // reset the cube's state
+    }
+}
+
+static void generateCrossPrun()
+{
+    // Filled like the pruning tables in lookupTables.cpp: at the i-th
+    // iteration, the 18 moves are applied to all the states at depth i - 1
+    // and i is written for the new states found.
+
+    generateEdgeMove();
+
+    for (int i = 0; i < N_CROSS / 2; ++i)
+        crossPrun[i] = -1; // 11111111 in binary
+
+    int depth = 0, done = 1;
+    writeTable(crossPrun, 0, 0);
+
+    while (done != N_CROSS)
+    {
+        for (int i = 0; i < N_CROSS; ++i)
+        {
+            if (readTable(crossPrun, i) != depth) continue;
+
+            uint8_t edges[4], moved[4];
+            setCross(i, edges);
+
+            for (int m = 0; m < N_MOVE; ++m)
+            {
+                for (int e = 0; e < 4; ++e) moved[e] = edgeMove[edges[e]][m];
+
+                int cross = getCross(moved);
+                if (readTable(crossPrun, cross) != 0x0f) continue;
+
+                writeTable(crossPrun, cross, (signed char)(depth + 1));
+                done++;
+            }
+        }
+        depth++;
+    }
+}
+
+static bool searchCross(uint8_t edges[4], int depth, int lastFace,
+    rcube::Algorithm &moves)
+{
+    if (depth == 0) return true;
+
+    uint8_t moved[4];
+    for (int m = 0; m < N_MOVE; ++m)
+    {
+        // the same face twice in a row and opposite faces in both orders
+        // (they commute) are skipped
+        int face = m / 3;
+        if (face == lastFace || ((face ^ 1) == lastFace && face < lastFace))
+            continue;
+
+        for (int e = 0; e < 4; ++e) moved[e] = edgeMove[edges[e]][m];
+
+        // the table is exact, so only the moves that get closer to the
+        // solved cross are tried
+        if (readTable(crossPrun, getCross(moved)) >= depth) continue;
+
+        moves.push(ph1Moves[m]);
+        if (searchCross(moved, depth - 1, face, moves)) return true;
+        moves.algorithm.pop_back();
+    }
+    return false;
+}
+
+void initCrossTables()
+{
+    static std::once_flag generated;
+    std::call_once(generated, generateCrossPrun);
+}
+
+rcube::Algorithm solveCross(const CubieCube &cc)
+{
+    initCrossTables();
+
+    uint8_t edges[4];
+    setCross(getCross(cc), edges);
+
+    rcube::Algorithm moves;
+    for (int depth = readTable(crossPrun, getCross(edges)); ; ++depth)
+    {
+        if (searchCross(edges, depth, -1, moves)) return moves;
+    }
+}
+
+}; // namespace Kociemba
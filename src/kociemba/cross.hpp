@@ -0,0 +1,51 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#pragma once
+
+#include <rcube.hpp>
+#include "cubieCube.hpp"
+#include "lookupTables.hpp"
+
+// 12 * 11 * 10 * 9 positions times 2^4 orientations of the 4 cross edges
+#define N_CROSS 190080
+
+namespace Kociemba
+{
+
+// The cross coordinate describes the 4 edges of the D face (DR, DF, DL, DB):
+// their slots (ranked among the 11880 ordered choices of 4 slots out of 12)
+// times 16, plus their orientations (one bit per edge). It is 0 when the cross
+// is solved.
+int getCross(const CubieCube &cc);
+
+// The searches do not use the cross coordinate directly: each edge is
+// described by its slot * 2 + its orientation (24 values), so applying a move
+// only takes one lookup in edgeMove (edgeMove[edge][M] = new value after M).
+// getCross can also be computed from the values of DR, DF, DL and DB.
+extern uint8_t edgeMove[24][N_MOVE];
+int getCross(const uint8_t edges[4]);
+
+// Stores the number of moves required to solve the cross from all the 190080
+// values of the cross coordinate (all of them are <= 8). Each byte contains
+// two values (see readTable). Unlike the tables of lookupTables.hpp, this
+// one is small enough to be generated in memory (see initCrossTables), so it
+// is not written to a file.
+extern signed char crossPrun[N_CROSS / 2];
+
+// Generates edgeMove and crossPrun, only the first time it is called
+void initCrossTables();
+
+// Returns a shortest algorithm (made of the 18 moves of lookupTables.hpp) that
+// solves the 4 edges of the D face, found with IDA* using crossPrun as the
+// heuristic. The cube is expected to have its centers in their slots (see
+// rcube::PackedState::getReoriented).
+rcube::Algorithm solveCross(const CubieCube &cc);
+
+}; // namespace Kociemba
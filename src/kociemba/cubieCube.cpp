@@ -7,8 +7,6 @@
 * not, see: <https://mit-license.org>.
 */
 
-#include <map>
-
 #include "cubieCube.hpp"
 #include "misc.hpp"
 
@@ -42,123 +40,29 @@ static Edge epB[12] = {UR, UF, UL, BR, DR, DF, DL, BL, FR, FL, UB, DB};
 static uint8_t eoB[12] = {0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 1};
 
 
-// needed to convert a rcube::Cube to a Kociemba::CubieCube
-std::map<std::vector<rcube::Orientation>,Corner> orientsToCorner = {
-    {{{Axis::Y, 1}, {Axis::X, 1}, {Axis::Z, 1}}, URF},
-    {{{Axis::Y, 1}, {Axis::Z, 1}, {Axis::X, -1}}, UFL},
-    {{{Axis::Y, 1}, {Axis::X, -1}, {Axis::Z, -1}}, ULB},
-    {{{Axis::Y, 1}, {Axis::Z, -1}, {Axis::X, 1}}, UBR},
-    {{{Axis::Y, -1}, {Axis::Z, 1}, {Axis::X, 1}}, DFR},
-    {{{Axis::Y, -1}, {Axis::X, -1}, {Axis::Z, 1}}, DLF},
-    {{{Axis::Y, -1}, {Axis::Z, -1}, {Axis::X, -1}}, DBL},
-    {{{Axis::Y, -1}, {Axis::X, 1}, {Axis::Z, -1}}, DRB}
-};
-
-// needed to convert a rcube::Cube to a Kociemba::CubieCube
-std::map<std::vector<rcube::Orientation>,Edge> orientsToEdge = {
-    {{{Axis::Y, 1}, {Axis::X, 1}}, UR},
-    {{{Axis::Y, 1}, {Axis::Z, 1}}, UF},
-    {{{Axis::Y, 1}, {Axis::X, -1}}, UL},
-    {{{Axis::Y, 1}, {Axis::Z, -1}}, UB},
-    {{{Axis::Y, -1}, {Axis::X, 1}}, DR},
-    {{{Axis::Y, -1}, {Axis::Z, 1}}, DF},
-    {{{Axis::Y, -1}, {Axis::X, -1}}, DL},
-    {{{Axis::Y, -1}, {Axis::Z, -1}}, DB},
-    {{{Axis::Z, 1}, {Axis::X, 1}}, FR},
-    {{{Axis::Z, 1}, {Axis::X, -1}}, FL},
-    {{{Axis::Z, -1}, {Axis::X, -1}}, BL},
-    {{{Axis::Z, -1}, {Axis::X, 1}}, BR},
-};
-
-
 CubieCube::CubieCube()
 {
     restoreCube();
 }
 
-CubieCube::CubieCube(rcube::Cube cube)
-{
-    restoreCube();
+CubieCube::CubieCube(const rcube::Cube &cube)
+    : CubieCube(cube.getState().getReoriented())
+{}
 
-    // manage corners
-    for (auto it = orientsToCorner.begin(); it != orientsToCorner.end(); ++it)
-    {
-        rcube::Coordinates cPos(it->first[0], it->first[1], it->first[2]);
-
-        // get the colors of the corner at cPos
-        Color cols[3] = {
-            cube.getStickerAt(cPos, it->first[0]),
-            cube.getStickerAt(cPos, it->first[1]),
-            cube.getStickerAt(cPos, it->first[2])
-        };
-
-        // convert all colors to the orientation of the corresponging face
-        // (the one which as the center of that color).
-        rcube::Orientation orients[3] = {
-            cube.getFaceOrientation(cols[0]),
-            cube.getFaceOrientation(cols[1]),
-            cube.getFaceOrientation(cols[2]),
-        };
-
-        // get the coordinates that the corner would have if the cube were solved
-        rcube::Coordinates cubie(orients[0], orients[1], orients[2]);
-
-        // find the corresponding index in orientsToCorner
-        auto it1 = orientsToCorner.begin();
-        for (; it1 != orientsToCorner.end(); ++it1)
-        {
-            if (rcube::Coordinates(it1->first[0], it1->first[1], it1->first[2])
-                == cubie) break;
-        }
-
-        // which color between white and yellow is in the corner
-        Color udColor = cube.getFaceColor({Axis::Y, cubie.y()});
-
-        int ori = 0;
-        for (; ori < 3; ++ori)
-        {
-            if (cube.getStickerAt(cPos, it->first[ori]) == udColor) break;
-        }
-
-        cPerm[(int)it->second] = it1->second;
-        cOri[(int)it->second] = ori;
-    }
-
-    // manage edges
-    for (auto it = orientsToEdge.begin(); it != orientsToEdge.end(); ++it)
+CubieCube::CubieCube(const rcube::PackedState &state)
+{
+    // rcube::PackedState uses the same slots and orientations
+    for (int i = 0; i < 12; ++i)
     {
-        rcube::Coordinates ePos(it->first[0], it->first[1]);
-
-        // get the colors of the edge at ePos
-        Color cols[2] = {
-            cube.getStickerAt(ePos, it->first[0]),
-            cube.getStickerAt(ePos, it->first[1])
-        };
-
-        // convert all colors to the orientation of the corresponging face
-        // (the one which as the center of that color).
-        rcube::Orientation orients[2] = {
-            cube.getFaceOrientation(cols[0]),
-            cube.getFaceOrientation(cols[1])
-        };
-
-        // get the coordinates that the corner would have if the cube were solved
-        rcube::Coordinates cubie(orients[0], orients[1]);
-
-        // find the corresponding index in orientsToCorner
-        auto it1 = orientsToEdge.begin();
-        for (; it1 != orientsToEdge.end(); ++it1)
-        {
-            if (rcube::Coordinates(it1->first[0], it1->first[1]) == cubie)
-                break;
-        }
+        uint8_t val = state.data[rcube::PackedState::EDGES + i];
+        ePerm[i] = (Edge)(val & 0x0f);
+        eOri[i] = val >> 4;
 
-        // compute the edge's orientation
-        int ori = 0;
-        if (cube.getFaceColor(it1->first[0]) != cols[0]) ori = 1;
+        if (i > 7) continue;
 
-        ePerm[(int)it->second] = it1->second;
-        eOri[(int)it->second] = ori;
+        val = state.data[rcube::PackedState::CORNERS + i];
+        cPerm[i] = (Corner)(val & 0x0f);
+        cOri[i] = val >> 4;
     }
 }
 
@@ -230,7 +134,17 @@ void CubieCube::cornerMultiply(const CubieCube &c)
     for (int i = 0; i < 8; ++i)
     {
         newCPerm[i] = cPerm[c.cPerm[i]];
-        newCOri[i] = (cOri[c.cPerm[i]] + c.cOri[i]) % 3;
+
+        int oriA = cOri[c.cPerm[i]];
+        int oriB = c.cOri[i];
+
+        if (oriA < 3 && oriB < 3) newCOri[i] = (oriA + oriB) % 3;
+        // c is mirrored: the result is mirrored too
+        else if (oriA < 3) newCOri[i] = 3 + (oriA + oriB) % 3;
+        // this cube is mirrored: c's twist is applied the other way round
+        else if (oriB < 3) newCOri[i] = 3 + (oriA - oriB + 3) % 3;
+        // both are mirrored: the result is a regular cube
+        else newCOri[i] = (oriA - oriB + 3) % 3;
     }
 
     for (int i = 0; i < 8; ++i)
@@ -271,6 +185,34 @@ void CubieCube::restoreCube()
     }
 }
 
+rcube::PackedState CubieCube::getPackedState() const
+{
+    rcube::PackedState res;
+
+    for (int i = 0; i < 12; ++i)
+    {
+        res.data[rcube::PackedState::EDGES + i] = ePerm[i] | (eOri[i] << 4);
+
+        if (i > 7) continue;
+
+        res.data[rcube::PackedState::CORNERS + i] = cPerm[i] | (cOri[i] << 4);
+    }
+    return res;
+}
+
+bool CubieCube::operator==(const CubieCube &c) const
+{
+    for (int i = 0; i < 12; ++i)
+    {
+        if (ePerm[i] != c.ePerm[i] || eOri[i] != c.eOri[i]) return false;
+
+        if (i > 7) continue;
+
+        if (cPerm[i] != c.cPerm[i] || cOri[i] != c.cOri[i]) return false;
+    }
+    return true;
+}
+
 uint16_t CubieCube::getFlip()
 {
     uint16_t res = 0;
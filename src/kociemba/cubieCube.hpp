@@ -37,7 +37,11 @@ namespace Kociemba
         CubieCube();
 
         // initialize by copying the state of a rcube::Cube
-        CubieCube(rcube::Cube cube);
+        CubieCube(const rcube::Cube &cube);
+
+        // initialize from a rcube::PackedState (the centers are ignored, see
+        // rcube::PackedState::getReoriented)
+        CubieCube(const rcube::PackedState &state);
 
         // initialize a move cube: this is basically a solved cube with only
         // the desired move applied
@@ -49,7 +53,8 @@ namespace Kociemba
         // useful when B is a move cube: multipying A times B means applying move
         // B to A
 
-        // multiplication limited to the corners
+        // multiplication limited to the corners. Mirrored cubes (used for the
+        // symmetries, see symmetry.hpp) have corner orientations from 3 to 5
         void cornerMultiply(const CubieCube &c);
 
         // multiplication limited to the edges
@@ -67,6 +72,11 @@ namespace Kociemba
         // restore the cube to the solved state
         void restoreCube();
 
+        // convert to a rcube::PackedState (with the centers in their slots)
+        rcube::PackedState getPackedState() const;
+
+        bool operator==(const CubieCube &c) const;
+
         // The flip is a number between 0 and 2048 that contains all the
         // orientations of the 12 edges (only 11 actually, the last one is
         // deduced from the others). Its digits in base 2 are the single
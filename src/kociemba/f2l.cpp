@@ -0,0 +1,358 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#include <vector>
+#include <mutex>
+#include <algorithm>
+
+#include "f2l.hpp"
+#include "cross.hpp"
+
+extern std::vector<rcube::Move> ph1Moves;
+
+namespace Kociemba
+{
+
+signed char pairPrun[4][4][N_PAIR * 24];
+
+// twoPairsPrun[couple][pair1 * N_PAIR + pair2] = moves required to solve 2 pairs
+static signed char twoPairsPrun[6][N_PAIR * N_PAIR];
+
+// the 6 couples of slots, in the order of twoPairsPrun
+static const int slotCouples[6][2] = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3},
+    {2, 3}};
+
+// flip coordinate after a move (same as flipMove, but generated in memory) and
+// number of moves required to orient all the edges
+static uint16_t eoMove[N_FLIP][N_MOVE];
+static signed char eoPrun[N_FLIP];
+
+// cornerMove[corner][M] = new slot * 3 + orientation of a corner after move M
+static uint8_t cornerMove[24][N_MOVE];
+
+static const Edge crossEdges[4] = {DR, DF, DL, DB};
+
+// A F2L search only needs the 4 cross edges and the 4 pairs, each piece being
+// described by its slot and orientation
+struct F2lState
+{
+    uint8_t cross[4];
+    uint8_t corners[4];
+    uint8_t edges[4];
+    uint16_t flip;
+
+    F2lState(const CubieCube &cc);
+    F2lState() = default;
+
+    // Applies a move in place. The searches undo it by applying the inverse
+    // move, so the state is never copied
+    void apply(int move);
+    int pair(int slot) const { return corners[slot] * 24 + edges[slot]; }
+};
+
+F2lState::F2lState(const CubieCube &cc)
+{
+    flip = CubieCube(cc).getFlip();
+
+    for (int slot = 0; slot < 12; ++slot)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            if (cc.ePerm[slot] == crossEdges[i])
+                cross[i] = slot * 2 + cc.eOri[slot];
+            if (cc.ePerm[slot] == FR + i)
+                edges[i] = slot * 2 + cc.eOri[slot];
+            if (slot < 8 && cc.cPerm[slot] == DFR + i)
+                corners[i] = slot * 3 + cc.cOri[slot];
+        }
+    }
+}
+
+void F2lState::apply(int move)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        cross[i] = edgeMove[cross[i]][move];
+        corners[i] = cornerMove[corners[i]][move];
+        edges[i] = edgeMove[edges[i]][move];
+    }
+    flip = eoMove[flip][move];
+}
+
+// index of the inverse of a move (X and X' are swapped, X2 stays the same)
+static int inverseMove(int move)
+{
+    return move + 2 - 2 * (move % 3);
+}
+
+int getPair(const CubieCube &cc, int slot)
+{
+    return F2lState(cc).pair(slot);
+}
+
+int getSolvedSlots(const CubieCube &cc)
+{
+    int res = 0;
+    for (int slot = 0; slot < 4; ++slot)
+    {
+        if (cc.cPerm[DFR + slot] == DFR + slot && cc.cOri[DFR + slot] == 0 &&
+            cc.ePerm[FR + slot] == FR + slot && cc.eOri[FR + slot] == 0)
+            res |= 1 << slot;
+    }
+    return res;
+}
+
+static void generateCornerMove()
+{
+    CubieCube cube = CubieCube();
+    auto orients = rcube::Orientation::iterate();
+
+    for (int k = 0; k < 6; ++k)
+    {
+        rcube::Move mv(orients[k], 1);
+
+        for (int j = 0; j < 3; ++j)
+        {
+            cube.cornerMultiply(mv);
+
+            // the corner in slot cube.cPerm[i] moves to slot i
+            for (int i = 0; i < 8; ++i)
+            {
+                for (int ori = 0; ori < 3; ++ori)
+                {
+                    cornerMove[cube.cPerm[i] * 3 + ori][3 * k + j] =
+                        i * 3 + (ori + cube.cOri[i]) % 3;
+                }
+            }
+        }
+        cube.cornerMultiply(mv); // reset the cube's state
+    }
+}
+
+static void generatePairPrun()
+{
+    initCrossTables(); // for edgeMove
+    generateCornerMove();
+
+    // the tables are small, so each depth is found by scanning all the states
+    for (int slot = 0; slot < 4; ++slot)
+    {
+        for (int e = 0; e < 4; ++e)
+        {
+            signed char *table = pairPrun[slot][e];
+            std::fill(table, table + N_PAIR * 24, -1);
+            table[((DFR + slot) * 3 * 24 + (FR + slot) * 2) * 24 +
+                crossEdges[e] * 2] = 0;
+
+            // the states with the two edges in the same slot are never
+            // reached, so the search ends when a depth adds no new states
+            for (int depth = 0, found = 1; found != 0; ++depth)
+            {
+                found = 0;
+                for (int i = 0; i < N_PAIR * 24; ++i)
+                {
+                    if (table[i] != depth) continue;
+
+                    int pair = i / 24;
+                    for (int m = 0; m < N_MOVE; ++m)
+                    {
+                        int moved = (cornerMove[pair / 24][m] * 24 +
+                            edgeMove[pair % 24][m]) * 24 + edgeMove[i % 24][m];
+                        if (table[moved] != -1) continue;
+
+                        table[moved] = depth + 1;
+                        found++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void generateEoPrun()
+{
+    CubieCube cube = CubieCube();
+    auto orients = rcube::Orientation::iterate();
+
+    for (int i = 0; i < N_FLIP; ++i)
+    {
+        cube.setFlip(i);
+
+        for (int k = 0; k < 6; ++k)
+        {
+            rcube::Move mv(orients[k], 1);
+
+            for (int j = 0; j < 3; ++j)
+            {
+                cube.edgeMultiply(mv);
+                eoMove[i][3 * k + j] = cube.getFlip();
+            }
+            cube.edgeMultiply(mv); // reset the cube's state
+        }
+    }
+
+    std::fill(eoPrun, eoPrun + N_FLIP, -1);
+    eoPrun[0] = 0;
+
+    for (int depth = 0, done = 1; done != N_FLIP; ++depth)
+    {
+        for (int i = 0; i < N_FLIP; ++i)
+        {
+            if (eoPrun[i] != depth) continue;
+
+            for (int m = 0; m < N_MOVE; ++m)
+            {
+                if (eoPrun[eoMove[i][m]] != -1) continue;
+
+                eoPrun[eoMove[i][m]] = depth + 1;
+                done++;
+            }
+        }
+    }
+}
+
+static void generateTwoPairsPrun()
+{
+    for (int c = 0; c < 6; ++c)
+    {
+        int a = slotCouples[c][0], b = slotCouples[c][1];
+        signed char *table = twoPairsPrun[c];
+
+        std::fill(table, table + N_PAIR * N_PAIR, -1);
+        table[((DFR + a) * 3 * 24 + (FR + a) * 2) * N_PAIR +
+            (DFR + b) * 3 * 24 + (FR + b) * 2] = 0;
+
+        // same as above: states with two pieces in the same slot are skipped
+        for (int depth = 0, found = 1; found != 0; ++depth)
+        {
+            found = 0;
+            for (int i = 0; i < N_PAIR * N_PAIR; ++i)
+            {
+                if (table[i] != depth) continue;
+
+                int p1 = i / N_PAIR, p2 = i % N_PAIR;
+                for (int m = 0; m < N_MOVE; ++m)
+                {
+                    int moved = (cornerMove[p1 / 24][m] * 24 +
+                        edgeMove[p1 % 24][m]) * N_PAIR +
+                        cornerMove[p2 / 24][m] * 24 + edgeMove[p2 % 24][m];
+                    if (table[moved] != -1) continue;
+
+                    table[moved] = depth + 1;
+                    found++;
+                }
+            }
+        }
+    }
+}
+
+// Lower bound of the number of moves needed to solve the cross and the pairs
+// in mask (and to orient the edges with F2L_ORIENT_EDGES)
+static int f2lDistance(const F2lState &state, int mask)
+{
+    int dist = readTable(crossPrun, getCross(state.cross));
+    if (mask & F2L_ORIENT_EDGES) dist = std::max(dist, (int)eoPrun[state.flip]);
+
+    for (int slot = 0; slot < 4; ++slot)
+    {
+        if (!(mask & (1 << slot))) continue;
+
+        int pair = state.pair(slot) * 24;
+        for (int e = 0; e < 4; ++e)
+        {
+            dist = std::max(dist,
+                (int)pairPrun[slot][e][pair + state.cross[e]]);
+        }
+    }
+    for (int c = 0; c < 6; ++c)
+    {
+        int a = slotCouples[c][0], b = slotCouples[c][1];
+        if (!(mask & (1 << a)) || !(mask & (1 << b))) continue;
+
+        dist = std::max(dist,
+            (int)twoPairsPrun[c][state.pair(a) * N_PAIR + state.pair(b)]);
+    }
+    return dist;
+}
+
+// Same bounds as f2lDistance, but it stops as soon as one of them is >= depth.
+// The bounds are checked from the cheapest to the most expensive one.
+static bool isFarther(const F2lState &state, int mask, int depth)
+{
+    for (int slot = 0; slot < 4; ++slot)
+    {
+        if (!(mask & (1 << slot))) continue;
+
+        const signed char *table = pairPrun[slot][0] + state.pair(slot) * 24;
+        for (int e = 0; e < 4; ++e, table += N_PAIR * 24)
+            if (table[state.cross[e]] >= depth) return true;
+    }
+
+    if ((mask & F2L_ORIENT_EDGES) && eoPrun[state.flip] >= depth) return true;
+
+    for (int c = 0; c < 6; ++c)
+    {
+        int a = slotCouples[c][0], b = slotCouples[c][1];
+        if (!(mask & (1 << a)) || !(mask & (1 << b))) continue;
+
+        if (twoPairsPrun[c][state.pair(a) * N_PAIR + state.pair(b)] >= depth)
+            return true;
+    }
+
+    return readTable(crossPrun, getCross(state.cross)) >= depth;
+}
+
+// The moves are applied to state and undone when they do not lead to a
+// solution. If one is found, the state is left as it is.
+static bool searchF2l(F2lState &state, int mask, int depth, int lastFace,
+    rcube::Algorithm &moves)
+{
+    if (depth == 0) return true;
+
+    for (int m = 0; m < N_MOVE; ++m)
+    {
+        // same rules as searchCross
+        int face = m / 3;
+        if (face == lastFace || ((face ^ 1) == lastFace && face < lastFace))
+            continue;
+
+        state.apply(m);
+        if (!isFarther(state, mask, depth))
+        {
+            moves.push(ph1Moves[m]);
+            if (searchF2l(state, mask, depth - 1, face, moves)) return true;
+            moves.algorithm.pop_back();
+        }
+        state.apply(inverseMove(m));
+    }
+    return false;
+}
+
+rcube::Algorithm solveF2l(const CubieCube &cc, int slots)
+{
+    static std::once_flag generated;
+    std::call_once(generated, []() {
+        generatePairPrun();
+        generateTwoPairsPrun();
+        generateEoPrun();
+    });
+
+    F2lState state(cc);
+
+    // the pairs that are already solved have to be solved at the end as well
+    int mask = slots | getSolvedSlots(cc);
+
+    rcube::Algorithm moves;
+    for (int depth = f2lDistance(state, mask); ; ++depth)
+    {
+        if (searchF2l(state, mask, depth, -1, moves)) return moves;
+    }
+}
+
+}; // namespace Kociemba
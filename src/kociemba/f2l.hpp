@@ -0,0 +1,50 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#pragma once
+
+#include <rcube.hpp>
+#include "cubieCube.hpp"
+#include "lookupTables.hpp"
+
+// 24 values of the corner times 24 values of the edge of a pair
+#define N_PAIR 576
+
+// added to the slots given to solveF2l to orient all the edges as well
+#define F2L_ORIENT_EDGES 16
+
+namespace Kociemba
+{
+
+// The 4 F2L slots are numbered as the slice edges: FR (with corner DFR), FL
+// (DLF), BL (DBL) and BR (DRB). A pair coordinate is (slot * 3 + orientation)
+// of the corner times 24 plus (slot * 2 + orientation) of the edge.
+int getPair(const CubieCube &cc, int slot);
+
+// Returns a bitmask of the slots whose pair is solved (bit i = slot i)
+int getSolvedSlots(const CubieCube &cc);
+
+// pairPrun[slot][e][pair * 24 + edge] = number of moves required to solve the
+// pair of a slot together with the e-th cross edge (DR, DF, DL, DB), whose
+// value is edge = slot * 2 + orientation (the rest of the cube is ignored).
+// These tables are generated in memory by the first call to solveF2l.
+extern signed char pairPrun[4][4][N_PAIR * 24];
+
+// Returns a shortest algorithm (made of the 18 moves of lookupTables.hpp) that
+// solves the pairs of the given slots (a bitmask, bit i = slot i) and the
+// cross, while keeping the pairs that are already solved in place. It is found
+// with IDA*, using crossPrun and pairPrun as the heuristics.
+// With F2L_ORIENT_EDGES in slots, the edges of the last layer get oriented too
+// (as in ZBLS/VHLS, so that the last layer can be solved with COLL/ZBLL).
+// When the cross is not solved this gives an XCross. Solving more than one
+// slot (or a cross together with a slot) at once can take a long time.
+// Like solveCross, the cube is expected to have its centers in their slots.
+rcube::Algorithm solveF2l(const CubieCube &cc, int slots);
+
+}; // namespace Kociemba
@@ -9,6 +9,7 @@
 
 #include <vector>
 #include <iostream>
+#include <mutex>
 
 #include "cubieCube.hpp"
 #include "fileManager.hpp"
@@ -403,7 +404,7 @@ void generateTable(const std::string &table, const std::string path)
     else if (table == "sliceUdEdgesPrun") generateSliceUdEdgesPrun(path);
 }
 
-void initTables()
+static void loadTables()
 {
     std::string path = STD_PATH;
     std::string tables[9] = {"twistMove", "flipMove", "sliceSortedMove",
@@ -460,4 +461,10 @@ void initTables()
         path + "/" + "sliceCornersPrun");
 }
 
+void initTables()
+{
+    static std::once_flag loaded;
+    std::call_once(loaded, loadTables);
+}
+
 } // namespace Kociemba
\ No newline at end of file
@@ -99,7 +99,9 @@ void writeTable(signed char *table, int index, signed char value);
 signed char readTable(signed char *table, int index);
 
 // Load the tables from the corresponding files or regenerate them if the files
-// do not exist. This function requires CLI interaction with the user.
+// do not exist. This function requires CLI interaction with the user. The
+// tables are only loaded by the first call (it is safe to call it from
+// multiple threads).
 void initTables();
 
 } // namespace Kociemba
\ No newline at end of file
@@ -53,11 +53,16 @@ void KociembaSolver::useRobotMode(const rcube::Orientation &face)
     _robotFace = Kociemba::getFaceNumber(face);
 }
 
+void KociembaSolver::setVerbose(bool verbose)
+{
+    _verbose = verbose;
+}
+
 void searchPh1 (
     uint16_t twist, // current twist: needs to be brought to 0
     uint16_t flip, // current flip: needs to be brought to 0
     uint16_t slice, // current slice: needs to be brought to 0
-    rcube::Algorithm prevMoves, // already applied moves for phase 1
+    rcube::Algorithm &prevMoves, // already applied moves for phase 1
     int dist, // lower bound for the number of moves needed to reach G1
     int left, // number of moves after which the maximum length allowed to
               // phase 1 is exceeded
@@ -109,23 +114,27 @@ void searchPh1 (
         );
         if (newDist >= left) continue;
 
-        rcube::Algorithm newAlgo = prevMoves;
-        newAlgo.push(move);
+        // the moves are pushed to prevMoves and removed after the recursive
+        // call, so that the sequence is never copied
+        prevMoves.push(move);
 
         if (newDist == 0)
         {
             // check if it has already been found
+            bool found = false;
             for (auto it = solutions->begin(); it < solutions->end(); ++it)
             {
-                if (it->to_string() == newAlgo.to_string()) return;
+                if (*it == prevMoves) found = true;
             }
             
-            solutions->push_back(newAlgo);
+            if (!found) solutions->push_back(prevMoves);
+            prevMoves.algorithm.pop_back();
             return;
         }
 
-        searchPh1(newTwist, newFlip, newSlice, newAlgo, newDist, left - 1,
+        searchPh1(newTwist, newFlip, newSlice, prevMoves, newDist, left - 1,
             solutions, toDiscard);
+        prevMoves.algorithm.pop_back();
     }
 }
 
@@ -133,7 +142,7 @@ void searchPh2 (
     uint16_t corners, // current corners: needs to be brought to 0
     uint16_t udEdges, // current udEdges: needs to be brought to 0
     uint16_t sliceSorted, // current sliceSorted: needs to be brought to 0
-    rcube::Algorithm prevMoves, // already applied moves for phase 2
+    rcube::Algorithm &prevMoves, // already applied moves for phase 2
     int left, // number of moves after which the maximum length allowed to
               // phase 2 is exceeded
     rcube::Algorithm *shortestSol, // stores the sortest solution found
@@ -192,21 +201,22 @@ void searchPh2 (
         );
         if (newDist >= left) continue;
 
-        rcube::Algorithm newAlgo = prevMoves;
-        newAlgo.push(move);
+        prevMoves.push(move);
 
         if (newDist == 0)
         {
-            if (newAlgo.length() + ph1Len < *shortestLen)
+            if (prevMoves.length() + ph1Len < *shortestLen)
             {
-                *shortestSol = newAlgo;
-                *shortestLen = newAlgo.length() + ph1Len;
+                *shortestSol = prevMoves;
+                *shortestLen = prevMoves.length() + ph1Len;
             }
+            prevMoves.algorithm.pop_back();
             return;
         }
 
-        searchPh2(newCorners, newUDEdges, newSliceSorted, newAlgo,
+        searchPh2(newCorners, newUDEdges, newSliceSorted, prevMoves,
             left - 1, shortestSol, ph1Len, shortestLen, endTime, toDiscard);
+        prevMoves.algorithm.pop_back();
     }
 }
 
@@ -216,19 +226,20 @@ void runPh2Search(Kociemba::CubieCube cc, const rcube::Algorithm &ph1Solution,
     *solution = rcube::Algorithm(DUMMY_ALGO);
     int shortestLen = 32;
 
+    rcube::Algorithm moves;
     int maxDepth = 12;
     while (shortestLen == 32)
     {
         if (time(NULL) > endTime) return;
 
         searchPh2(cc.getCorners(), cc.getUDEdges(), cc.getSliceSorted(),
-            rcube::Algorithm(), maxDepth, solution, ph1Solution.length(),
+            moves, maxDepth, solution, ph1Solution.length(),
             &shortestLen, endTime, toDiscard);
         maxDepth++;
     }
 }
 
-bool compareAlgo(rcube::Algorithm a, rcube::Algorithm b)
+bool compareAlgo(const rcube::Algorithm &a, const rcube::Algorithm &b)
 {
     return a.length() < b.length();
 }
@@ -240,11 +251,12 @@ rcube::Algorithm KociembaSolver::solve()
     std::vector<rcube::Algorithm> ph1Solutions;
     long endTime = time(NULL) + _timeout;
     
+    rcube::Algorithm moves;
     int maxDepth = 4;
     while (ph1Solutions.size() < _threads)
     {
         searchPh1(cc.getTwist(), cc.getFlip(), cc.getSliceSorted() / 24,
-            rcube::Algorithm(), 0, maxDepth, &ph1Solutions, _robotFace);
+            moves, 0, maxDepth, &ph1Solutions, _robotFace);
         maxDepth++;
     }
 
@@ -262,8 +274,11 @@ rcube::Algorithm KociembaSolver::solve()
         rcube::Algorithm solution = ph1Solutions[0] + ph2Solution;
         solution.normalize();
 
-        std::cout << "[KOCIEMBA] Final solution: " << solution.to_string() <<
-            " (" << solution.length() << " moves)\n";
+        if (_verbose)
+        {
+            std::cout << "[KOCIEMBA] Final solution: " << solution.to_string()
+                << " (" << solution.length() << " moves)\n";
+        }
 
         return solution;
     }
@@ -300,8 +315,11 @@ rcube::Algorithm KociembaSolver::solve()
 
     std::sort(solutions.begin(), solutions.end(), compareAlgo);
 
-    std::cout << "[KOCIEMBA] Final solution: " << solutions[0].to_string() <<
-        " (" << solutions[0].length() << " moves)\n";
+    if (_verbose)
+    {
+        std::cout << "[KOCIEMBA] Final solution: " << solutions[0].to_string()
+            << " (" << solutions[0].length() << " moves)\n";
+    }
 
     return solutions[0];
 }
\ No newline at end of file
@@ -0,0 +1,222 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#include <cstring>
+#include <stdexcept>
+
+#include "symmetry.hpp"
+#include "lookupTables.hpp"
+
+namespace Kociemba
+{
+
+// cPerm, cOri, ePerm, eOri values for the 4 basic symmetries
+
+// 120° clockwise rotation around the URF-DBL diagonal
+static Corner cpURF3[8] = {URF, DFR, DLF, UFL, UBR, DRB, DBL, ULB};
+static uint8_t coURF3[8] = {1, 2, 1, 2, 2, 1, 2, 1};
+static Edge epURF3[12] = {UF, FR, DF, FL, UB, BR, DB, BL, UR, DR, DL, UL};
+static uint8_t eoURF3[12] = {1, 0, 1, 0, 1, 0, 1, 0, 1, 1, 1, 1};
+
+// 180° rotation around the F-B axis
+static Corner cpF2[8] = {DLF, DFR, DRB, DBL, UFL, URF, UBR, ULB};
+static uint8_t coF2[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+static Edge epF2[12] = {DL, DF, DR, DB, UL, UF, UR, UB, FL, FR, BR, BL};
+static uint8_t eoF2[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+// 90° clockwise rotation around the U-D axis
+static Corner cpU4[8] = {UBR, URF, UFL, ULB, DRB, DFR, DLF, DBL};
+static uint8_t coU4[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+static Edge epU4[12] = {UB, UR, UF, UL, DB, DR, DF, DL, BR, FR, FL, BL};
+static uint8_t eoU4[12] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1};
+
+// reflection through the plane of the U, D, F and B centers
+static Corner cpLR2[8] = {UFL, URF, UBR, ULB, DLF, DFR, DRB, DBL};
+static uint8_t coLR2[8] = {3, 3, 3, 3, 3, 3, 3, 3};
+static Edge epLR2[12] = {UL, UF, UR, UB, DL, DF, DR, DB, FL, FR, BR, BL};
+static uint8_t eoLR2[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+// the 18 moves, in the same order as the lookup tables
+static const rcube::Move symMoves[N_MOVE] = {
+    rcube::Move('L', 1), rcube::Move('L', 2), rcube::Move('L', -1),
+    rcube::Move('R', 1), rcube::Move('R', 2), rcube::Move('R', -1),
+    rcube::Move('D', 1), rcube::Move('D', 2), rcube::Move('D', -1),
+    rcube::Move('U', 1), rcube::Move('U', 2), rcube::Move('U', -1),
+    rcube::Move('B', 1), rcube::Move('B', 2), rcube::Move('B', -1),
+    rcube::Move('F', 1), rcube::Move('F', 2), rcube::Move('F', -1)
+};
+
+static CubieCube basicSymCube(Corner *cp, uint8_t *co, Edge *ep, uint8_t *eo)
+{
+    CubieCube res;
+    for (int i = 0; i < 12; ++i)
+    {
+        res.ePerm[i] = ep[i];
+        res.eOri[i] = eo[i];
+
+        if (i > 7) continue;
+
+        res.cPerm[i] = cp[i];
+        res.cOri[i] = co[i];
+    }
+    return res;
+}
+
+struct SymTables
+{
+    CubieCube symCubes[N_SYM];
+    int invSym[N_SYM];
+
+    // symMove[s][m] = index of S * m * S^-1 in symMoves
+    int symMove[N_SYM][N_MOVE];
+
+    SymTables();
+};
+
+SymTables::SymTables()
+{
+    CubieCube urf3 = basicSymCube(cpURF3, coURF3, epURF3, eoURF3);
+    CubieCube f2 = basicSymCube(cpF2, coF2, epF2, eoF2);
+    CubieCube u4 = basicSymCube(cpU4, coU4, epU4, eoU4);
+    CubieCube lr2 = basicSymCube(cpLR2, coLR2, epLR2, eoLR2);
+
+    CubieCube cc;
+    for (int i = 0; i < N_SYM; ++i)
+    {
+        symCubes[i] = cc;
+
+        cc.multiply(u4);
+        if (i % 4 == 3) cc.multiply(lr2);
+        if (i % 8 == 7) cc.multiply(f2);
+        if (i % 16 == 15) cc.multiply(urf3);
+    }
+
+    CubieCube solved;
+    for (int i = 0; i < N_SYM; ++i)
+    {
+        for (int k = 0; k < N_SYM; ++k)
+        {
+            CubieCube prod = symCubes[i];
+            prod.multiply(symCubes[k]);
+            if (prod == solved) invSym[i] = k;
+        }
+    }
+
+    CubieCube moveCubes[N_MOVE];
+    for (int m = 0; m < N_MOVE; ++m) moveCubes[m] = CubieCube(symMoves[m]);
+
+    for (int s = 0; s < N_SYM; ++s)
+    {
+        for (int m = 0; m < N_MOVE; ++m)
+        {
+            CubieCube conj = symCubes[s];
+            conj.multiply(moveCubes[m]);
+            conj.multiply(symCubes[invSym[s]]);
+
+            for (int k = 0; k < N_MOVE; ++k)
+            {
+                if (conj == moveCubes[k]) symMove[s][m] = k;
+            }
+        }
+    }
+}
+
+static const SymTables& getSymTables()
+{
+    static const SymTables tables;
+    return tables;
+}
+
+const CubieCube& getSymCube(int sym)
+{
+    return getSymTables().symCubes[sym];
+}
+
+int getInvSym(int sym)
+{
+    return getSymTables().invSym[sym];
+}
+
+CubieCube conjugate(const CubieCube &cc, int sym)
+{
+    const SymTables &tables = getSymTables();
+
+    CubieCube res = tables.symCubes[sym];
+    res.multiply(cc);
+    res.multiply(tables.symCubes[tables.invSym[sym]]);
+    return res;
+}
+
+rcube::Move conjugateMove(const rcube::Move &move, int sym)
+{
+    int q = ((move.direction % 4) + 4) % 4;
+    if (q == 0) return move;
+
+    for (int m = 0; m < N_MOVE; ++m)
+    {
+        if (symMoves[m].face != move.face) continue;
+        if (((symMoves[m].direction % 4) + 4) % 4 != q) continue;
+
+        return symMoves[getSymTables().symMove[sym][m]];
+    }
+    throw std::invalid_argument("Unsupported move: " + move.to_string());
+}
+
+rcube::SymmetryKey getSymmetryKey(const CubieCube &cc, bool useInverse)
+{
+    CubieCube candidates[2] = {
+        cc,
+        CubieCube(cc.getPackedState().getInverse())
+    };
+
+    rcube::SymmetryKey best;
+    bool found = false;
+
+    for (int i = 0; i < (useInverse ? 2 : 1); ++i)
+    {
+        for (int s = 0; s < N_SYM; ++s)
+        {
+            rcube::PackedState state = conjugate(candidates[i], s)
+                .getPackedState();
+
+            if (found && std::memcmp(state.data, best.state.data, 32) >= 0)
+                continue;
+
+            best.state = state;
+            best.symmetry = s;
+            best.inverse = (i == 1);
+            found = true;
+        }
+    }
+
+    best.key = best.state.getHash();
+    return best;
+}
+
+}; // namespace Kociemba
+
+rcube::SymmetryKey rcube::Cube::getSymmetryKey(bool useInverse) const
+{
+    return Kociemba::getSymmetryKey(Kociemba::CubieCube(*this), useInverse);
+}
+
+rcube::Algorithm rcube::SymmetryKey::mapSolution(
+    const rcube::Algorithm &solution) const
+{
+    // state = S * cube * S^-1, so if X solves state then S^-1 * X * S solves
+    // the cube (or its inverse, in which case it has to be reversed)
+    int inv = Kociemba::getInvSym(symmetry);
+
+    rcube::Algorithm res;
+    for (const rcube::Move &move : solution.algorithm)
+        res.push(Kociemba::conjugateMove(move, inv));
+
+    if (inverse) return res.reverse();
+    return res;
+}
@@ -0,0 +1,45 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#pragma once
+
+#include <rcube.hpp>
+#include "cubieCube.hpp"
+
+#define N_SYM 48
+
+namespace Kociemba
+{
+
+// The 48 symmetries of the cube are generated by 4 basic symmetries: a 120°
+// rotation around the URF-DBL diagonal (URF3), a 180° rotation around the F-B
+// axis (F2), a 90° rotation around the U-D axis (U4) and a reflection through
+// the plane that contains the U, D, F and B centers (LR2). Symmetry number
+// i is URF3^(i / 16) * F2^((i / 8) % 2) * LR2^((i / 4) % 2) * U4^(i % 4).
+
+// Returns the CubieCube of a symmetry (a solved cube transformed by it)
+const CubieCube& getSymCube(int sym);
+
+// Returns the index of the inverse of a symmetry
+int getInvSym(int sym);
+
+// Returns S * cc * S^-1, where S is the given symmetry: this is the state
+// that cc becomes when the cube is looked at through the symmetry
+CubieCube conjugate(const CubieCube &cc, int sym);
+
+// Returns the move m' such that S * m * S^-1 = m', where S is the given
+// symmetry (only R, L, U, D, F and B are supported)
+rcube::Move conjugateMove(const rcube::Move &move, int sym);
+
+// Finds the symmetry that gives the lowest rcube::PackedState (compared byte
+// by byte) when it is used to conjugate cc (and its inverse as well when
+// useInverse = true)
+rcube::SymmetryKey getSymmetryKey(const CubieCube &cc, bool useInverse);
+
+}; // namespace Kociemba
@@ -10,6 +10,8 @@
 #ifndef IGNORE_LUA
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <functional>
 
@@ -32,14 +34,17 @@ bool checkStatus(lua_State *L, int r)
     return false;
 }
 
-typedef int (RcubeLua::*memberFunc)(lua_State *L);
-
 template <memberFunc func>
-int runFunction(lua_State *L) {
+int callFunction(lua_State *L) {
     RcubeLua *instance = *static_cast<RcubeLua**>(lua_getextraspace(L));
     return (instance->*func)(L);
 }
 
+template <memberFunc func>
+int runFunction(lua_State *L) {
+    return protect<&callFunction<func>>(L);
+}
+
 void initLua(lua_State *L)
 {
     luaL_openlibs(L);
@@ -65,34 +70,214 @@ void initLua(lua_State *L)
     lua_register(L, "removeRotations", &runFunction<&RcubeLua::removeRotations>);
     lua_register(L, "solveCfop", &runFunction<&RcubeLua::solveCfop>);
     lua_register(L, "solveKociemba", &runFunction<&RcubeLua::solveKociemba>);
+    lua_register(L, "getFacelets", &runFunction<&RcubeLua::getFacelets>);
+    lua_register(L, "faceMatchesAny", &runFunction<&RcubeLua::faceMatchesAny>);
+    lua_register(L, "performAlgorithms",
+        &runFunction<&RcubeLua::performAlgorithms>);
+    lua_register(L, "solveCubes", &runFunction<&RcubeLua::solveCubes>);
+    lua_register(L, "getCube", &runFunction<&RcubeLua::getCube>);
+    lua_register(L, "setCube", &runFunction<&RcubeLua::setCube>);
+    lua_register(L, "spawn", &runFunction<&RcubeLua::spawn>);
+    lua_register(L, "runTasks", &runFunction<&RcubeLua::runTasks>);
+    lua_register(L, "solveCfopAsync", &runFunction<&RcubeLua::solveCfopAsync>);
+    lua_register(L, "solveKociembaAsync",
+        &runFunction<&RcubeLua::solveKociembaAsync>);
+
+    registerTypes(L);
 }
 
-int rcube::Cube::runScript(const std::string &path)
+// Compiled chunks are kept until there are more than MAX_CACHED_CHUNKS of
+// them, in which case the cache restarts
+#define MAX_CACHED_CHUNKS 256
+
+// Pushes a shallow copy of the table at idx
+static void copyTable(lua_State *L, int idx)
 {
-    lua_State *L = luaL_newstate();
-    initLua(L);
+    idx = lua_absindex(L, idx);
+    lua_newtable(L);
+    lua_pushnil(L);
+    while (lua_next(L, idx))
+    {
+        lua_pushvalue(L, -2);
+        lua_insert(L, -2);
+        lua_rawset(L, -4);
+    }
+}
 
-    RcubeLua instance(this);
-    *static_cast<RcubeLua**>(lua_getextraspace(L)) = &instance;
+// Gives the table at dest the same keys and values as the shallow copy at src
+static void restoreTable(lua_State *L, int dest, int src)
+{
+    dest = lua_absindex(L, dest);
+    src = lua_absindex(L, src);
 
-    int status = checkStatus(L, luaL_dofile(L, path.c_str()));
+    // the new keys are removed (they are collected first, since a table
+    // cannot be modified while traversing it)
+    lua_newtable(L);
+    int keys = lua_gettop(L), count = 0;
+    lua_pushnil(L);
+    while (lua_next(L, dest))
+    {
+        lua_pop(L, 1);
+        lua_pushvalue(L, -1);
+        if (lua_rawget(L, src) == LUA_TNIL)
+        {
+            lua_pushvalue(L, -2);
+            lua_rawseti(L, keys, ++count);
+        }
+        lua_pop(L, 1);
+    }
+    for (int i = 1; i <= count; ++i)
+    {
+        lua_rawgeti(L, keys, i);
+        lua_pushnil(L);
+        lua_rawset(L, dest);
+    }
+    lua_pop(L, 1);
 
-    lua_close(L);
-    return status;
+    // and the initial ones are restored, in case they have been overwritten
+    lua_pushnil(L);
+    while (lua_next(L, src))
+    {
+        lua_pushvalue(L, -2);
+        lua_insert(L, -2);
+        lua_rawset(L, dest);
+    }
 }
 
-int rcube::Cube::runCommand(const std::string &cmd)
+ScriptEngine::ScriptEngine()
+    : L(luaL_newstate()), _instance(nullptr)
 {
-    lua_State *L = luaL_newstate();
     initLua(L);
+    *static_cast<RcubeLua**>(lua_getextraspace(L)) = &_instance;
+    _instance._scheduler = &_scheduler;
 
-    RcubeLua instance(this);
-    *static_cast<RcubeLua**>(lua_getextraspace(L)) = &instance;
+    // shallow copy of the initial globals
+    lua_pushglobaltable(L);
+    copyTable(L, -1);
+    _globals = luaL_ref(L, LUA_REGISTRYINDEX);
 
-    int status = checkStatus(L, luaL_dostring(L, cmd.c_str()));
+    // and of the tables they contain (string, math, ...), by table
+    lua_newtable(L);
+    lua_pushnil(L);
+    while (lua_next(L, -3))
+    {
+        if (lua_istable(L, -1) && !lua_rawequal(L, -1, -4))
+        {
+            copyTable(L, -1);
+            lua_rawset(L, -4);
+        }
+        else lua_pop(L, 1);
+    }
+    _libraries = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_pop(L, 1);
+}
 
+ScriptEngine::~ScriptEngine()
+{
     lua_close(L);
+}
+
+ScriptEngine& ScriptEngine::get()
+{
+    thread_local ScriptEngine engine;
+    return engine;
+}
+
+void ScriptEngine::resetGlobals()
+{
+    lua_settop(L, 0);
+    lua_pushglobaltable(L);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, _globals);
+    restoreTable(L, 1, 2);
+
+    // the library tables are restored as well, one level deep (a script
+    // could have added or replaced a function of string or math)
+    lua_rawgeti(L, LUA_REGISTRYINDEX, _libraries);
+    lua_pushnil(L);
+    while (lua_next(L, -2))
+    {
+        restoreTable(L, -2, -1);
+        lua_pop(L, 1);
+    }
+    lua_settop(L, 0);
+}
+
+int ScriptEngine::run(rcube::Cube *cube, const std::string &source,
+    const std::string &chunkName)
+{
+    // a run started while another one is in progress (from a C++ function
+    // called by the script) gets a state of its own
+    if (_instance._cube != nullptr)
+    {
+        ScriptEngine nested;
+        return nested.run(cube, source, chunkName);
+    }
+
+    _instance._cube = cube;
+
+    auto it = _chunks.find(source);
+    if (it != _chunks.end())
+    {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, it->second);
+    }
+    else
+    {
+        if (!checkStatus(L, luaL_loadbuffer(L, source.data(), source.size(),
+            chunkName.c_str())))
+        {
+            lua_settop(L, 0);
+            return 0;
+        }
+
+        if (_chunks.size() >= MAX_CACHED_CHUNKS)
+        {
+            for (auto &chunk : _chunks)
+                luaL_unref(L, LUA_REGISTRYINDEX, chunk.second);
+            _chunks.clear();
+        }
+
+        lua_pushvalue(L, -1);
+        _chunks[source] = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+
+    int status = checkStatus(L, lua_pcall(L, 0, LUA_MULTRET, 0));
+    lua_settop(L, 0);
+
+    // the tasks started by the script run until they end, unless the script
+    // has failed
+    if (status)
+        status = _scheduler.run(L);
+    else
+        _scheduler.clear(L);
+
+    resetGlobals();
+    _instance._cube = nullptr;
     return status;
 }
 
+int rcube::Cube::runScript(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "cannot open " << path << std::endl;
+        return 0;
+    }
+
+    std::stringstream source;
+    source << file.rdbuf();
+
+    // a leading #! line (as in lua's standalone interpreter) is skipped, but
+    // kept as an empty line so that the line numbers do not change
+    std::string code = source.str();
+    if (code.rfind("#", 0) == 0) code.erase(0, code.find('\n'));
+
+    return ScriptEngine::get().run(this, code, "@" + path);
+}
+
+int rcube::Cube::runCommand(const std::string &cmd)
+{
+    return ScriptEngine::get().run(this, cmd, cmd);
+}
+
 #endif
\ No newline at end of file
@@ -11,7 +11,9 @@
 
 #include <iostream>
 #include <string>
-#include <map>
+#include <string_view>
+#include <utility>
+#include <new>
 
 extern "C"
 {
@@ -22,30 +24,117 @@ extern "C"
 #include "luaAPI.hpp"
 
 
-void pushTable(lua_State *L, const std::map<std::string, int> &data)
+// The coordinates and orientations are exchanged as tables like
+// {x=#, y=#, z=#} and {axis=#, direction=#}. A missing table (or field) is read
+// as 0.
+static int getField(lua_State *L, int idx, const char *name)
 {
-    lua_createtable(L, data.size(), 0);
-    int newTable = lua_gettop(L);
+    if (!lua_istable(L, idx)) return 0;
 
-    for (auto it = data.begin(); it != data.end(); ++it)
-    {
-        lua_pushnumber(L, it->second);
-        lua_setfield(L, -2, it->first.c_str());
-    }
+    lua_getfield(L, idx, name);
+    int value = (int)lua_tointeger(L, -1);
+    lua_pop(L, 1);
+    return value;
 }
 
-void loadTable(lua_State *L, std::map<std::string, int> *data, int stackIdx = 1)
+static rcube::Coordinates toCoordinates(lua_State *L, int idx)
 {
-    if (!lua_istable(L, stackIdx)) return;
+    return rcube::Coordinates(getField(L, idx, "x"), getField(L, idx, "y"),
+        getField(L, idx, "z"));
+}
 
-    for (auto it = data->begin(); it != data->end(); ++it)
-    {
-        lua_pushstring(L, it->first.c_str());
-        lua_gettable(L, stackIdx);
-        it->second = lua_tointeger(L, -1);
-        lua_pop(L, 1);
-    }
-    return;
+static rcube::Orientation toOrientation(lua_State *L, int idx)
+{
+    return {(Axis)getField(L, idx, "axis"), getField(L, idx, "direction")};
+}
+
+static void pushCoordinates(lua_State *L, const rcube::Coordinates &coords)
+{
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, coords.x());
+    lua_setfield(L, -2, "x");
+    lua_pushinteger(L, coords.y());
+    lua_setfield(L, -2, "y");
+    lua_pushinteger(L, coords.z());
+    lua_setfield(L, -2, "z");
+}
+
+static void pushOrientation(lua_State *L, const rcube::Orientation &orient)
+{
+    lua_createtable(L, 0, 2);
+    lua_pushinteger(L, orient.axis);
+    lua_setfield(L, -2, "axis");
+    lua_pushinteger(L, orient.direction);
+    lua_setfield(L, -2, "direction");
+}
+
+rcube::Cube* pushCube(lua_State *L, const rcube::Cube &cube)
+{
+    rcube::Cube *res = new (lua_newuserdata(L, sizeof(rcube::Cube)))
+        rcube::Cube(cube);
+    luaL_setmetatable(L, LUA_CUBE);
+    return res;
+}
+
+rcube::Algorithm* pushAlgorithm(lua_State *L, rcube::Algorithm &&algo)
+{
+    rcube::Algorithm *res = new (lua_newuserdata(L, sizeof(rcube::Algorithm)))
+        rcube::Algorithm(std::move(algo));
+    luaL_setmetatable(L, LUA_ALGORITHM);
+    return res;
+}
+
+rcube::Cube* checkCube(lua_State *L, int idx)
+{
+    return static_cast<rcube::Cube*>(luaL_checkudata(L, idx, LUA_CUBE));
+}
+
+rcube::Cube* checkCubeItem(lua_State *L, int idx, int i)
+{
+    lua_rawgeti(L, idx, i);
+    void *ud = luaL_testudata(L, -1, LUA_CUBE);
+    if (ud == nullptr)
+        luaL_argerror(L, idx, lua_pushfstring(L, "item %d is not a Cube", i));
+
+    return static_cast<rcube::Cube*>(ud);
+}
+
+rcube::Algorithm* checkAlgorithm(lua_State *L, int idx)
+{
+    void *ud = luaL_testudata(L, idx, LUA_ALGORITHM);
+    if (ud != nullptr) return static_cast<rcube::Algorithm*>(ud);
+
+    // strings are parsed into a new userdata, which then replaces them on
+    // the stack: the algorithm is freed by the garbage collector even if
+    // luaL_error is raised
+    size_t len;
+    const char *str = luaL_checklstring(L, idx, &len);
+    idx = idx < 0 ? lua_gettop(L) + idx + 1 : idx;
+
+    rcube::Algorithm *algo = pushAlgorithm(L, rcube::Algorithm());
+    int error = rcube::Algorithm::parse(std::string_view(str, len),
+        &algo->algorithm);
+    if (error != -1)
+        luaL_error(L, "invalid character in algorithm at position %d", error);
+
+    lua_replace(L, idx);
+    return algo;
+}
+
+// Reads a move given as a face letter and a number of turns. The face is
+// checked before the move is built, since rcube::Cube ignores unknown faces
+static rcube::Move checkMove(lua_State *L, int faceIdx, int dirIdx)
+{
+    static const std::string_view faces = "RLUDFBrludfbMESxyz";
+
+    size_t len;
+    const char *face = luaL_checklstring(L, faceIdx, &len);
+    int direction = (int)luaL_checkinteger(L, dirIdx);
+
+    if (len != 1 || faces.find(face[0]) == std::string_view::npos)
+        luaL_argerror(L, faceIdx, lua_pushfstring(L, "unknown move '%s'", face));
+
+    return rcube::Move(face[0], direction);
 }
 
 RcubeLua::RcubeLua(rcube::Cube *cube)
@@ -66,16 +155,13 @@ int RcubeLua::scramble(lua_State *L)
 
 int RcubeLua::performMove(lua_State *L)
 {
-    std::string move = lua_tostring(L, 1);
-    int direction = (int)lua_tonumber(L, 2);
-
-    _cube->performMove(rcube::Move(move[0], direction));
+    _cube->performMove(checkMove(L, 1, 2));
     return 1;
 }
 
 int RcubeLua::performAlgorithm(lua_State *L)
 {
-    _cube->performAlgorithm(lua_tostring(L, 1));
+    _cube->performAlgorithm(*checkAlgorithm(L, 1));
     return 1;
 }
 
@@ -98,6 +184,7 @@ int RcubeLua::rotateTo(lua_State *L)
     {
         std::cerr << e.what() << std::endl;
     }
+    return 0;
 }
 
 int RcubeLua::find(lua_State *L)
@@ -119,55 +206,31 @@ int RcubeLua::find(lua_State *L)
                 static_cast<Color>(stks[2])); break;
     }
 
-    std::map<std::string, int> toReturn = {{"x", result.x()},
-        {"y", result.y()}, {"z", result.z()}};
-
-    pushTable(L, toReturn);
-    return 1; 
+    pushCoordinates(L, result);
+    return 1;
 }
 
 int RcubeLua::getStickerOrientation(lua_State *L)
 {
-    std::map<std::string, int> coords = {{"x", 0}, {"y", 0}, {"z", 0}};
-    loadTable(L, &coords);
-    rcube::Coordinates coordinates(coords["x"], coords["y"], coords["z"]);
-
     Color color = static_cast<Color>((lua_tostring(L, 2))[0]);
 
-    rcube::Orientation orient = _cube->getStickerOrientation(coordinates,
-        color);
+    pushOrientation(L, _cube->getStickerOrientation(toCoordinates(L, 1),
+        color));
 
-    std::map<std::string, int> toReturn = {{"axis", orient.axis},
-        {"direction", orient.direction}};
-    pushTable(L, toReturn);
-    
     return 1;
 }
 
 int RcubeLua::getStickerAt(lua_State *L)
 {
-    std::map<std::string, int> coords = {{"x", 0}, {"y", 0}, {"z", 0}};
-    loadTable(L, &coords, 1);
-    rcube::Coordinates coordinates(coords["x"], coords["y"], coords["z"]);
-
-    std::map<std::string, int> orient = {{"axis", 0}, {"direction", 0}};
-    loadTable(L, &orient, 2);
-    rcube::Orientation orientation = {(Axis)orient["axis"],
-        orient["direction"]};
-
-    char res[2] = {(char)_cube->getStickerAt(coordinates, orientation), '\0'};
+    char res[2] = {(char)_cube->getStickerAt(toCoordinates(L, 1),
+        toOrientation(L, 2)), '\0'};
     lua_pushstring(L, res);
     return 1;
 }
 
 int RcubeLua::getFaceColor(lua_State *L)
 {
-    std::map<std::string, int> orient = {{"axis", 0}, {"direction", 0}};
-    loadTable(L, &orient);
-    rcube::Orientation orientation = {(Axis)orient["axis"],
-        orient["direction"]};
-
-    char res[2] = {(char)_cube->getFaceColor(orientation), '\0'};
+    char res[2] = {(char)_cube->getFaceColor(toOrientation(L, 1)), '\0'};
     lua_pushstring(L, res);
     return 1;
 }
@@ -175,10 +238,7 @@ int RcubeLua::getFaceColor(lua_State *L)
 int RcubeLua::getFaceOrientation(lua_State *L)
 {
     Color col = (Color)lua_tostring(L, 1)[0];
-    rcube::Orientation ort = _cube->getFaceOrientation(col);
-    std::map<std::string, int> orient = {{"axis", (int)ort.axis},
-        {"direction", ort.direction}};
-    pushTable(L, orient);
+    pushOrientation(L, _cube->getFaceOrientation(col));
     return 1;
 }
 
@@ -190,64 +250,34 @@ int RcubeLua::display(lua_State *L)
 
 int RcubeLua::faceMatches(lua_State *L)
 {
-    std::map<std::string, int> orient = {{"axis", 0}, {"direction", 0}};
-    loadTable(L, &orient);
-    rcube::Orientation orientation = {(Axis)orient["axis"],
-        orient["direction"]};
-
     std::string expr = lua_tostring(L, 2);
 
-    std::map<std::string, int> destTmp = {{"x", 0}, {"y", 0}, {"z", 0}};
-    loadTable(L, &destTmp, 3);
-    rcube::Coordinates dest(destTmp["x"], destTmp["y"], destTmp["z"]);
-
-    lua_pushboolean(L, _cube->faceMatches(orientation, expr, dest));
+    lua_pushboolean(L, _cube->faceMatches(toOrientation(L, 1), expr,
+        toCoordinates(L, 3)));
     return 1;
 }
 
 int RcubeLua::layerMatches(lua_State *L)
 {
-    std::map<std::string, int> layer = {{"axis", 0}, {"direction", 0}};
-    loadTable(L, &layer);
-    rcube::Orientation lOrient = {(Axis)layer["axis"], layer["direction"]};
-
     std::string expr = lua_tostring(L, 2);
 
-    std::map<std::string, int> destTmp = {{"x", 0}, {"y", 0}, {"z", 0}};
-    loadTable(L, &destTmp, 3);
-    rcube::Coordinates dest(destTmp["x"], destTmp["y"], destTmp["z"]);
-
-    std::map<std::string, int> orient = {{"axis", 0}, {"direction", 0}};
-    loadTable(L, &orient, 4);
-    rcube::Orientation dOrient = {(Axis)orient["axis"], orient["direction"]};
-
-    lua_pushboolean(L, _cube->layerMatches(lOrient, expr, dest, dOrient));
+    lua_pushboolean(L, _cube->layerMatches(toOrientation(L, 1), expr,
+        toCoordinates(L, 3), toOrientation(L, 4)));
     return 1;
 }
 
 int RcubeLua::layerAndFaceMatch(lua_State *L)
 {
-    std::map<std::string, int> layer = {{"axis", 0}, {"direction", 0}};
-    loadTable(L, &layer);
-    rcube::Orientation lOrient = {(Axis)layer["axis"], layer["direction"]};
-
     std::string expr = lua_tostring(L, 2);
 
-    std::map<std::string, int> destTmp = {{"x", 0}, {"y", 0}, {"z", 0}};
-    loadTable(L, &destTmp, 3);
-    rcube::Coordinates dest(destTmp["x"], destTmp["y"], destTmp["z"]);
-
-    std::map<std::string, int> orient = {{"axis", 0}, {"direction", 0}};
-    loadTable(L, &orient, 4);
-    rcube::Orientation dOrient = {(Axis)orient["axis"], orient["direction"]};
-
-    lua_pushboolean(L, _cube->layerAndFaceMatch(lOrient, expr, dest, dOrient));
+    lua_pushboolean(L, _cube->layerAndFaceMatch(toOrientation(L, 1), expr,
+        toCoordinates(L, 3), toOrientation(L, 4)));
     return 1;
 }
 
 int RcubeLua::normalizeAlgo(lua_State *L)
 {
-    rcube::Algorithm algo(lua_tostring(L, 1));
+    rcube::Algorithm algo = *checkAlgorithm(L, 1);
     algo.normalize();
 
     lua_pushstring(L, algo.to_string().c_str());
@@ -256,7 +286,7 @@ int RcubeLua::normalizeAlgo(lua_State *L)
 
 int RcubeLua::reverseAlgo(lua_State *L)
 {
-    rcube::Algorithm algo(lua_tostring(L, 1));
+    rcube::Algorithm algo = *checkAlgorithm(L, 1);
     algo = algo.reverse();
     
     lua_pushstring(L, algo.to_string().c_str());
@@ -265,7 +295,7 @@ int RcubeLua::reverseAlgo(lua_State *L)
 
 int RcubeLua::removeRotations(lua_State *L)
 {
-    rcube::Algorithm algo(lua_tostring(L, 1));
+    rcube::Algorithm algo = *checkAlgorithm(L, 1);
     algo.removeRotations();
 
     lua_pushstring(L, algo.to_string().c_str());
@@ -286,4 +316,329 @@ int RcubeLua::solveKociemba(lua_State *L)
     return 1;
 }
 
+int RcubeLua::getFacelets(lua_State *L)
+{
+    char facelets[54];
+    {
+        rcube::Net net = _cube->netRender();
+
+        // same order as display()
+        int i = 0;
+        for (const rcube::Orientation &o : rcube::Orientation::iterate())
+        {
+            for (int y = 1; y >= -1; --y)
+            {
+                for (int x = -1; x <= 1; ++x)
+                    facelets[i++] = (char)net.faces[o].stickers[{x, y}];
+            }
+        }
+    }
+
+    lua_pushlstring(L, facelets, 54);
+    return 1;
+}
+
+int RcubeLua::faceMatchesAny(lua_State *L)
+{
+    luaL_checktype(L, 2, LUA_TTABLE);
+    int count = (int)lua_rawlen(L, 2);
+
+    rcube::Orientation orientation = toOrientation(L, 1);
+    rcube::Coordinates dest = toCoordinates(L, 3);
+
+    // the search stops at the first match, since the face may then have been
+    // rotated to dest
+    for (int i = 1; i <= count; ++i)
+    {
+        lua_rawgeti(L, 2, i);
+        size_t len;
+        const char *expr = luaL_checklstring(L, -1, &len);
+
+        if (_cube->faceMatches(orientation, std::string(expr, len), dest))
+        {
+            lua_pushinteger(L, i);
+            return 1;
+        }
+        lua_pop(L, 1);
+    }
+
+    lua_pushnil(L);
+    return 1;
+}
+
+int RcubeLua::performAlgorithms(lua_State *L)
+{
+    luaL_checktype(L, 1, LUA_TTABLE);
+    int count = (int)lua_rawlen(L, 1);
+
+    if (lua_istable(L, 2))
+    {
+        luaL_argcheck(L, (int)lua_rawlen(L, 2) == count, 2,
+            "expected one algorithm per cube");
+
+        for (int i = 1; i <= count; ++i)
+        {
+            rcube::Cube *cube = checkCubeItem(L, 1, i);
+            lua_rawgeti(L, 2, i);
+            cube->performAlgorithm(*checkAlgorithm(L, -1));
+            lua_pop(L, 2);
+        }
+        return 0;
+    }
+
+    // the same algorithm for all the cubes: its moves are only combined once
+    rcube::PackedState compiled = checkAlgorithm(L, 2)->compile();
+    for (int i = 1; i <= count; ++i)
+    {
+        checkCubeItem(L, 1, i)->performAlgorithm(compiled);
+        lua_pop(L, 1);
+    }
+    return 0;
+}
+
+int RcubeLua::getCube(lua_State *L)
+{
+    pushCube(L, *_cube);
+    return 1;
+}
+
+int RcubeLua::setCube(lua_State *L)
+{
+    *_cube = *checkCube(L, 1);
+    return 0;
+}
+
+
+// Cube userdata: the functions above are also available as methods, which are
+// called with a copy of the state's RcubeLua bound to the userdata
+template <memberFunc func>
+static int callMethod(lua_State *L)
+{
+    RcubeLua instance = **static_cast<RcubeLua**>(lua_getextraspace(L));
+    instance._cube = checkCube(L, 1);
+    lua_remove(L, 1);
+    return (instance.*func)(L);
+}
+
+template <memberFunc func>
+static int cubeMethod(lua_State *L)
+{
+    return protect<&callMethod<func>>(L);
+}
+
+static int newCube(lua_State *L)
+{
+    if (lua_isnoneornil(L, 1))
+    {
+        pushCube(L, rcube::Cube());
+    }
+    else if (luaL_testudata(L, 1, LUA_CUBE))
+    {
+        pushCube(L, *checkCube(L, 1));
+    }
+    else
+    {
+        const rcube::Algorithm &algo = *checkAlgorithm(L, 1);
+        pushCube(L, rcube::Cube())->performAlgorithm(algo);
+    }
+    return 1;
+}
+
+static int cubeGc(lua_State *L)
+{
+    checkCube(L, 1)->~Cube();
+    return 0;
+}
+
+static int cubeEq(lua_State *L)
+{
+    lua_pushboolean(L, *checkCube(L, 1) == *checkCube(L, 2));
+    return 1;
+}
+
+// cube * algo returns a new cube, the original one is not modified
+static int cubeMul(lua_State *L)
+{
+    const rcube::Algorithm &algo = *checkAlgorithm(L, 2);
+    pushCube(L, *checkCube(L, 1))->performAlgorithm(algo);
+    return 1;
+}
+
+static int cubePerformMove(lua_State *L)
+{
+    rcube::Cube *cube = checkCube(L, 1);
+    cube->performMove(checkMove(L, 2, 3));
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int cubePerformAlgorithm(lua_State *L)
+{
+    rcube::Cube *cube = checkCube(L, 1);
+    cube->performAlgorithm(*checkAlgorithm(L, 2));
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int cubeCopy(lua_State *L)
+{
+    pushCube(L, *checkCube(L, 1));
+    return 1;
+}
+
+static const luaL_Reg cubeMethods[] = {
+    {"scramble", &cubeMethod<&RcubeLua::scramble>},
+    {"performMove", &protect<&cubePerformMove>},
+    {"performAlgorithm", &protect<&cubePerformAlgorithm>},
+    {"isSolved", &cubeMethod<&RcubeLua::isSolved>},
+    {"rotateTo", &cubeMethod<&RcubeLua::rotateTo>},
+    {"find", &cubeMethod<&RcubeLua::find>},
+    {"getStickerOrientation", &cubeMethod<&RcubeLua::getStickerOrientation>},
+    {"getStickerAt", &cubeMethod<&RcubeLua::getStickerAt>},
+    {"getFaceColor", &cubeMethod<&RcubeLua::getFaceColor>},
+    {"getFaceOrientation", &cubeMethod<&RcubeLua::getFaceOrientation>},
+    {"display", &cubeMethod<&RcubeLua::display>},
+    {"faceMatches", &cubeMethod<&RcubeLua::faceMatches>},
+    {"layerMatches", &cubeMethod<&RcubeLua::layerMatches>},
+    {"layerAndFaceMatch", &cubeMethod<&RcubeLua::layerAndFaceMatch>},
+    {"faceMatchesAny", &cubeMethod<&RcubeLua::faceMatchesAny>},
+    {"getFacelets", &cubeMethod<&RcubeLua::getFacelets>},
+    {"solveCfop", &cubeMethod<&RcubeLua::solveCfop>},
+    {"solveKociemba", &cubeMethod<&RcubeLua::solveKociemba>},
+    {"solveCfopAsync", &cubeMethod<&RcubeLua::solveCfopAsync>},
+    {"solveKociembaAsync", &cubeMethod<&RcubeLua::solveKociembaAsync>},
+    {"copy", &protect<&cubeCopy>},
+    {nullptr, nullptr}
+};
+
+static const luaL_Reg cubeMeta[] = {
+    {"__gc", &cubeGc},
+    {"__eq", &protect<&cubeEq>},
+    {"__mul", &protect<&cubeMul>},
+    {nullptr, nullptr}
+};
+
+
+// Algorithm userdata
+static int newAlgorithm(lua_State *L)
+{
+    if (lua_isnoneornil(L, 1))
+        pushAlgorithm(L, rcube::Algorithm());
+    else
+        pushAlgorithm(L, rcube::Algorithm(*checkAlgorithm(L, 1)));
+    return 1;
+}
+
+static int algorithmGc(lua_State *L)
+{
+    checkAlgorithm(L, 1)->~Algorithm();
+    return 0;
+}
+
+static int algorithmEq(lua_State *L)
+{
+    lua_pushboolean(L, *checkAlgorithm(L, 1) == *checkAlgorithm(L, 2));
+    return 1;
+}
+
+// used for both a .. b and a + b
+static int algorithmConcat(lua_State *L)
+{
+    const rcube::Algorithm &a = *checkAlgorithm(L, 1);
+    const rcube::Algorithm &b = *checkAlgorithm(L, 2);
+    pushAlgorithm(L, a + b);
+    return 1;
+}
+
+// algo * factor (or factor * algo) multiplies the directions of the moves
+static int algorithmMul(lua_State *L)
+{
+    int algoIdx = lua_isnumber(L, 1) ? 2 : 1;
+    int factor = (int)luaL_checkinteger(L, 3 - algoIdx);
+    pushAlgorithm(L, *checkAlgorithm(L, algoIdx) * factor);
+    return 1;
+}
+
+static int algorithmUnm(lua_State *L)
+{
+    pushAlgorithm(L, checkAlgorithm(L, 1)->reverse());
+    return 1;
+}
+
+static int algorithmLen(lua_State *L)
+{
+    lua_pushinteger(L, checkAlgorithm(L, 1)->length());
+    return 1;
+}
+
+static int algorithmToString(lua_State *L)
+{
+    lua_pushstring(L, checkAlgorithm(L, 1)->to_string().c_str());
+    return 1;
+}
+
+static int algorithmNormalize(lua_State *L)
+{
+    checkAlgorithm(L, 1)->normalize();
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int algorithmRemoveRotations(lua_State *L)
+{
+    checkAlgorithm(L, 1)->removeRotations();
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int algorithmCopy(lua_State *L)
+{
+    pushAlgorithm(L, rcube::Algorithm(*checkAlgorithm(L, 1)));
+    return 1;
+}
+
+static const luaL_Reg algorithmMethods[] = {
+    {"normalize", &protect<&algorithmNormalize>},
+    {"reverse", &protect<&algorithmUnm>},
+    {"removeRotations", &protect<&algorithmRemoveRotations>},
+    {"length", &protect<&algorithmLen>},
+    {"copy", &protect<&algorithmCopy>},
+    {nullptr, nullptr}
+};
+
+static const luaL_Reg algorithmMeta[] = {
+    {"__gc", &algorithmGc},
+    {"__eq", &protect<&algorithmEq>},
+    {"__concat", &protect<&algorithmConcat>},
+    {"__add", &protect<&algorithmConcat>},
+    {"__mul", &protect<&algorithmMul>},
+    {"__unm", &protect<&algorithmUnm>},
+    {"__len", &protect<&algorithmLen>},
+    {"__tostring", &protect<&algorithmToString>},
+    {nullptr, nullptr}
+};
+
+
+static void newType(lua_State *L, const char *name, const luaL_Reg *meta,
+    const luaL_Reg *methods)
+{
+    luaL_newmetatable(L, name);
+    luaL_setfuncs(L, meta, 0);
+
+    lua_newtable(L);
+    luaL_setfuncs(L, methods, 0);
+    lua_setfield(L, -2, "__index");
+
+    lua_pop(L, 1);
+}
+
+void registerTypes(lua_State *L)
+{
+    newType(L, LUA_CUBE, cubeMeta, cubeMethods);
+    newType(L, LUA_ALGORITHM, algorithmMeta, algorithmMethods);
+
+    lua_register(L, "Cube", &protect<&newCube>);
+    lua_register(L, "Algorithm", &protect<&newAlgorithm>);
+}
+
 #endif
\ No newline at end of file
@@ -11,11 +11,20 @@
 
 #ifndef IGNORE_LUA
 
+#include <string>
+#include <stdexcept>
+#include <unordered_map>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
 extern "C"
 {
     #include <lua.hpp>
 }
 
+class Scheduler;
+
 class RcubeLua
 {
 public:
@@ -59,7 +68,177 @@ public:
 
     int solveKociemba(lua_State *L);
 
+    int getFacelets(lua_State *L);
+
+    int faceMatchesAny(lua_State *L);
+
+    int performAlgorithms(lua_State *L);
+
+    int solveCubes(lua_State *L);
+
+    int getCube(lua_State *L);
+
+    int setCube(lua_State *L);
+
+    int spawn(lua_State *L);
+
+    int runTasks(lua_State *L);
+
+    int solveCfopAsync(lua_State *L);
+
+    int solveKociembaAsync(lua_State *L);
+
     rcube::Cube *_cube;
+    Scheduler *_scheduler = nullptr;
+};
+
+typedef int (RcubeLua::*memberFunc)(lua_State *L);
+
+// Calls func, turning the C++ exceptions it throws into Lua errors: they must
+// not cross the Lua C boundary. The error is raised once func has returned, so
+// that its objects are destroyed
+template <lua_CFunction func>
+int protect(lua_State *L)
+{
+    try
+    {
+        return func(L);
+    }
+    catch (const std::exception &e)
+    {
+        lua_pushstring(L, e.what());
+    }
+    return lua_error(L);
+}
+
+// Names of the metatables of the Cube and Algorithm userdata
+#define LUA_CUBE "rcube.Cube"
+#define LUA_ALGORITHM "rcube.Algorithm"
+
+// Creates the metatables of the userdata and registers their constructors
+// (the global functions Cube and Algorithm)
+void registerTypes(lua_State *L);
+
+// Push a copy of a cube or algorithm as a new userdata
+rcube::Cube* pushCube(lua_State *L, const rcube::Cube &cube);
+rcube::Algorithm* pushAlgorithm(lua_State *L, rcube::Algorithm &&algo);
+
+// Return the cube at the given index of the stack, or raise an error
+rcube::Cube* checkCube(lua_State *L, int idx);
+
+// Pushes the i-th item of the list at the given index of the stack and
+// returns it if it is a cube, otherwise raises an error
+rcube::Cube* checkCubeItem(lua_State *L, int idx, int i);
+
+// Returns the algorithm at the given index of the stack. A string is parsed
+// and replaced by a new Algorithm userdata, anything else raises an error
+rcube::Algorithm* checkAlgorithm(lua_State *L, int idx);
+
+// Runs the tasks (coroutines started by spawn) of a lua_State. When a task
+// calls an async solve, the solve is sent to a pool of worker threads shared by
+// all the states and the task yields: it is resumed with the solution once the
+// solve is done, while the other tasks keep running.
+class Scheduler
+{
+public:
+    Scheduler() = default;
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Starts the function below the nargs values at the top of the stack as a
+    // new task (the function and its arguments are popped). The task runs
+    // until it yields or ends
+    void spawn(lua_State *L, int nargs);
+
+    // Returns true if T is a task that can yield to the scheduler
+    bool isTask(lua_State *T) const;
+
+    // Solves cube (with CFOP or Kociemba) on a worker thread. task has to yield
+    // right after: it is resumed with an Algorithm, or with nil and an error
+    // message if the solver failed
+    void submit(lua_State *task, const rcube::Cube &cube, bool cfop);
+
+    // Resumes the tasks until all of them have ended. Returns false if any
+    // of them raised an error (which is printed to stderr)
+    bool run(lua_State *L);
+
+    // Drops all the tasks, once their solves are done
+    void clear(lua_State *L);
+
+private:
+    struct Task
+    {
+        int ref; // registry reference to the thread
+        bool waiting; // the task is waiting for a solve
+    };
+
+    struct Result
+    {
+        lua_State *task;
+        rcube::Algorithm solution;
+        std::string error;
+    };
+
+    std::unordered_map<lua_State*, Task> _tasks;
+
+    // tasks that have yielded without waiting for a solve
+    std::deque<lua_State*> _ready;
+
+    // solves completed by the workers
+    std::mutex _mutex;
+    std::condition_variable _done;
+    std::deque<Result> _results;
+    int _pending = 0;
+
+    bool _running = false;
+    bool _failed = false;
+
+    void resume(lua_State *T, lua_State *from, int nargs);
+    void finish(lua_State *T);
+};
+
+// Runs the Lua code of rcube::Cube::runCommand and rcube::Cube::runScript.
+// There is one engine per thread, which keeps the same lua_State for all the
+// cubes: the libraries and the rcube functions are only loaded once, the
+// chunks are only compiled the first time their source is run, and the
+// globals are reset after each run (so that runs do not see each other's
+// variables).
+class ScriptEngine
+{
+public:
+    ScriptEngine();
+    ~ScriptEngine();
+
+    ScriptEngine(const ScriptEngine&) = delete;
+    ScriptEngine& operator=(const ScriptEngine&) = delete;
+
+    // Returns the engine of the calling thread
+    static ScriptEngine& get();
+
+    // Runs source on cube. chunkName is used in the error messages. Returns 1
+    // on success, 0 on failure (the error is printed to stderr)
+    int run(rcube::Cube *cube, const std::string &source,
+        const std::string &chunkName);
+
+private:
+    lua_State *L;
+    RcubeLua _instance;
+    Scheduler _scheduler;
+
+    // registry references to the compiled chunks, by source
+    std::unordered_map<std::string, int> _chunks;
+
+    // registry reference to a copy of the globals made after the rcube
+    // functions have been registered
+    int _globals;
+
+    // registry reference to a table mapping each table among these globals
+    // (string, math, ...) to a copy of its initial content
+    int _libraries;
+
+    void resetGlobals();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,358 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#ifndef IGNORE_LUA
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <functional>
+
+extern "C"
+{
+    #include <lua.hpp>
+}
+
+#include <rcube.hpp>
+#include <solving.hpp>
+#include "luaAPI.hpp"
+
+// Threads that run the async solves of all the Lua states. They are started by
+// the first solve and stopped when the program exits.
+class WorkerPool
+{
+public:
+    static WorkerPool& get()
+    {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    void submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.push_back(std::move(job));
+        }
+        _available.notify_one();
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _available.notify_all();
+        for (std::thread &worker : _workers) worker.join();
+    }
+
+private:
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void()>> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _available;
+    bool _stop = false;
+
+    WorkerPool()
+    {
+        int threads = std::max(1u, std::thread::hardware_concurrency());
+        for (int i = 0; i < threads; ++i)
+            _workers.emplace_back(&WorkerPool::work, this);
+    }
+
+    void work()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _available.wait(lock, [this]() {
+                    return _stop || !_jobs.empty();
+                });
+                if (_stop) return;
+
+                job = std::move(_jobs.front());
+                _jobs.pop_front();
+            }
+            job();
+        }
+    }
+};
+
+
+// The cube is not modified, unlike in rcube::Cube::solveCfop and solveKociemba.
+// Kociemba is not verbose, since many solves may be running at once
+static rcube::Algorithm solve(const rcube::Cube &cube, bool cfop)
+{
+    if (cfop) return CfopSolver(cube).solve();
+
+    KociembaSolver solver(cube);
+    solver.setVerbose(false);
+    return solver.solve();
+}
+
+
+Scheduler::~Scheduler()
+{
+    // the workers must not write to a destroyed scheduler
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this]() { return (int)_results.size() == _pending; });
+}
+
+void Scheduler::spawn(lua_State *L, int nargs)
+{
+    lua_State *T = lua_newthread(L);
+    _tasks[T] = {luaL_ref(L, LUA_REGISTRYINDEX), false};
+
+    lua_xmove(L, T, nargs + 1);
+    resume(T, L, nargs);
+}
+
+bool Scheduler::isTask(lua_State *T) const
+{
+    return _tasks.count(T) != 0 && lua_isyieldable(T);
+}
+
+void Scheduler::submit(lua_State *task, const rcube::Cube &cube, bool cfop)
+{
+    _tasks[task].waiting = true;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending++;
+    }
+
+    WorkerPool::get().submit([this, task, cube, cfop]() {
+        Result res = {task};
+        try
+        {
+            res.solution = solve(cube, cfop);
+        }
+        catch (const std::exception &e)
+        {
+            res.error = e.what();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _results.push_back(std::move(res));
+        }
+        _done.notify_one();
+    });
+}
+
+void Scheduler::resume(lua_State *T, lua_State *from, int nargs)
+{
+    int nres;
+    int status = lua_resume(T, from, nargs, &nres);
+
+    if (status == LUA_YIELD)
+    {
+        lua_pop(T, nres);
+
+        // a task that yields by itself is resumed after the others
+        if (!_tasks[T].waiting) _ready.push_back(T);
+        return;
+    }
+
+    if (status != LUA_OK)
+    {
+        std::cerr << lua_tostring(T, -1) << std::endl;
+        _failed = true;
+    }
+    finish(T);
+}
+
+void Scheduler::finish(lua_State *T)
+{
+    luaL_unref(T, LUA_REGISTRYINDEX, _tasks[T].ref);
+    _tasks.erase(T);
+}
+
+bool Scheduler::run(lua_State *L)
+{
+    // the task would wait for itself
+    if (_running || _tasks.count(L) != 0)
+        luaL_error(L, "runTasks cannot be called by a task");
+    _running = true;
+
+    while (!_tasks.empty())
+    {
+        if (!_ready.empty())
+        {
+            lua_State *T = _ready.front();
+            _ready.pop_front();
+            resume(T, L, 0);
+            continue;
+        }
+
+        Result res;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _done.wait(lock, [this]() { return !_results.empty(); });
+
+            res = std::move(_results.front());
+            _results.pop_front();
+            _pending--;
+        }
+
+        lua_State *T = res.task;
+        _tasks[T].waiting = false;
+
+        if (res.error.empty())
+        {
+            pushAlgorithm(T, std::move(res.solution));
+            resume(T, L, 1);
+        }
+        else
+        {
+            lua_pushnil(T);
+            lua_pushstring(T, res.error.c_str());
+            resume(T, L, 2);
+        }
+    }
+
+    _running = false;
+
+    bool ok = !_failed;
+    _failed = false;
+    return ok;
+}
+
+void Scheduler::clear(lua_State *L)
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this]() { return (int)_results.size() == _pending; });
+        _results.clear();
+        _pending = 0;
+    }
+
+    for (auto &task : _tasks) luaL_unref(L, LUA_REGISTRYINDEX, task.second.ref);
+    _tasks.clear();
+    _ready.clear();
+    _running = false;
+    _failed = false;
+}
+
+
+int RcubeLua::spawn(lua_State *L)
+{
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    _scheduler->spawn(L, lua_gettop(L) - 1);
+    return 0;
+}
+
+int RcubeLua::runTasks(lua_State *L)
+{
+    lua_pushboolean(L, _scheduler->run(L));
+    return 1;
+}
+
+int RcubeLua::solveCubes(lua_State *L)
+{
+    static const char *methods[] = {"cfop", "kociemba", nullptr};
+    luaL_checktype(L, 1, LUA_TTABLE);
+    bool cfop = luaL_checkoption(L, 2, "cfop", methods) == 0;
+
+    // the cubes are checked before any C++ object is created, since a Lua
+    // error would skip their destructors
+    int count = (int)lua_rawlen(L, 1);
+    for (int i = 1; i <= count; ++i)
+    {
+        checkCubeItem(L, 1, i);
+        lua_pop(L, 1);
+    }
+
+    lua_createtable(L, count, 0);
+    bool failed = false;
+    {
+        std::vector<rcube::Algorithm> solutions(count);
+        std::string error;
+
+        std::mutex mutex;
+        std::condition_variable done;
+        int left = count;
+
+        for (int i = 0; i < count; ++i)
+        {
+            const rcube::Cube *cube = checkCubeItem(L, 1, i + 1);
+            lua_pop(L, 1);
+
+            WorkerPool::get().submit([&, cube, i]() {
+                std::string err;
+                try
+                {
+                    solutions[i] = solve(*cube, cfop);
+                }
+                catch (const std::exception &e)
+                {
+                    err = e.what();
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!err.empty()) error = err;
+                if (--left == 0) done.notify_one();
+            });
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]() { return left == 0; });
+
+        for (int i = 0; i < count; ++i)
+        {
+            pushAlgorithm(L, std::move(solutions[i]));
+            lua_rawseti(L, -2, i + 1);
+        }
+
+        if (!error.empty())
+        {
+            lua_pushstring(L, error.c_str());
+            failed = true;
+        }
+    }
+
+    if (failed) return lua_error(L);
+    return 1;
+}
+
+// Called when a task is resumed after an async solve: the stack contains the
+// values given by the scheduler above the first ctx values
+static int solveAsyncDone(lua_State *L, int status, lua_KContext ctx)
+{
+    if (lua_gettop(L) - ctx == 2) return lua_error(L);
+    return 1;
+}
+
+// Solves the cube of instance on the worker pool and yields, or solves it
+// right away if L is not a task (or cannot yield)
+static int solveAsync(lua_State *L, RcubeLua *instance, bool cfop)
+{
+    if (!instance->_scheduler->isTask(L))
+    {
+        pushAlgorithm(L, solve(*instance->_cube, cfop));
+        return 1;
+    }
+
+    instance->_scheduler->submit(L, *instance->_cube, cfop);
+    return lua_yieldk(L, 0, lua_gettop(L), &solveAsyncDone);
+}
+
+int RcubeLua::solveCfopAsync(lua_State *L)
+{
+    return solveAsync(L, this, true);
+}
+
+int RcubeLua::solveKociembaAsync(lua_State *L)
+{
+    return solveAsync(L, this, false);
+}
+
+#endif
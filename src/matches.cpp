@@ -7,129 +7,225 @@
 * not, see: <https://mit-license.org>.
 */
 
+#include <string>
+#include <cctype>
+#include <unordered_map>
+
 #include <rcube.hpp>
 
 #include "cfop/util.hpp"
 
-bool handleLetters(Color color, char given, char otherCase,
-    std::map<char, Color> *letterMapping)
+// Patterns are compiled once into a list of PatternOp (one per character),
+// so that matching does not need to interpret the characters again. Letters
+// are variables: the color they stand for is stored in a LetterBinding, which
+// is a plain array instead of a map.
+
+struct PatternOp
 {
-    // This is the part of stickerMatches which handles letters that do not
-    // indicate a color directly (i.e. variables)
+    enum Kind : uint8_t
+    {
+        ANY,     // '*'
+        IS,      // uppercase color: the sticker has that color
+        IS_NOT,  // lowercase color: the sticker has any other color
+        LETTER,  // a variable
+        INVALID  // never matches
+    };
+
+    Kind kind = INVALID;
+    Color color = Color::White; // for IS and IS_NOT
+    uint8_t letter = 0; // index of the letter (0-25 uppercase, 26-51 lowercase)
+    uint8_t other = 0; // index of the same letter in the other case
+    bool typeB = false; // letters of type B = {M,...,Z} (see documentation)
+};
+
+struct CompiledPattern
+{
+    int size = 0;
+    PatternOp ops[22]; // the longest patterns are those of layerAndFaceMatch
+};
+
+struct LetterBinding
+{
+    Color colors[52]; // (Color)0 = the letter is not bound yet
+    uint8_t typeBColors; // colors bound to letters of type B, as a bitmask
+
+    LetterBinding() { clear(); }
+    void clear()
+    {
+        for (Color &c : colors) c = (Color)0;
+        typeBColors = 0;
+    }
+};
 
-    // Letters of type A = {A,...,L}
-    // Letters of type B = {M,...,Z} (see documentation)
+static int colorBit(Color color)
+{
+    switch (color)
+    {
+        case Color::White: return 1;
+        case Color::Yellow: return 2;
+        case Color::Green: return 4;
+        case Color::Blue: return 8;
+        case Color::Red: return 16;
+        case Color::Orange: return 32;
+    }
+    return 0;
+}
+
+static PatternOp compileChar(char c)
+{
+    PatternOp op;
 
-    bool isTypeB = (int)given >= 77 && (int)otherCase >= 77;
+    switch (c)
+    {
+        case '*':
+            op.kind = PatternOp::ANY;
+            return op;
+
+        case 'W': case 'Y': case 'G': case 'B': case 'R': case 'O':
+            op.kind = PatternOp::IS;
+            op.color = static_cast<Color>(tolower(c));
+            return op;
+
+        case 'w': case 'y': case 'g': case 'b': case 'r': case 'o':
+            op.kind = PatternOp::IS_NOT;
+            op.color = static_cast<Color>(c);
+            return op;
+    }
 
-    if (letterMapping->find(given) != letterMapping->end())
+    // every other letter is a variable
+    if (isupper(c))
     {
-        return color == letterMapping->at(given);
+        op.letter = c - 'A';
+        op.other = op.letter + 26;
     }
-    else if (letterMapping->find(otherCase) != letterMapping->end())
+    else if (islower(c))
+    {
+        op.letter = c - 'a' + 26;
+        op.other = op.letter - 26;
+    }
+    else return op;
+
+    op.kind = PatternOp::LETTER;
+    op.typeB = tolower(c) >= 'm';
+    return op;
+}
+
+// Returns the compiled version of a pattern. Compiled patterns are cached per
+// thread, so each pattern is only compiled once (unless scripts generate more
+// than MAX_CACHED_PATTERNS different ones, in which case the cache restarts).
+#define MAX_CACHED_PATTERNS 4096
+
+static const CompiledPattern& compilePattern(const std::string &expr)
+{
+    thread_local std::unordered_map<std::string, CompiledPattern> cache;
+
+    auto it = cache.find(expr);
+    if (it != cache.end()) return it->second;
+    if (cache.size() >= MAX_CACHED_PATTERNS) cache.clear();
+
+    CompiledPattern &pattern = cache[expr];
+    if (expr.size() > 22) return pattern; // too long for any matcher
+
+    pattern.size = expr.size();
+    for (int i = 0; i < pattern.size; ++i)
+        pattern.ops[i] = compileChar(expr[i]);
+    return pattern;
+}
+
+static bool handleLetters(Color color, const PatternOp &op,
+    LetterBinding *binding)
+{
+    // This is the part of stickerMatches which handles letters that do not
+    // indicate a color directly (i.e. variables)
+
+    Color given = binding->colors[op.letter];
+    Color other = binding->colors[op.other];
+
+    if (given != (Color)0) return color == given;
+
+    if (other != (Color)0)
     {
-        if (isTypeB)
+        if (op.typeB)
         {
-            Color opposite = getOppositeColor(letterMapping->at(otherCase));
-            letterMapping->insert(std::pair<char, Color>(given, opposite));
+            Color opposite = getOppositeColor(other);
+            binding->colors[op.letter] = opposite;
+            binding->typeBColors |= colorBit(opposite);
             return color == opposite;
         }
 
-        return color != letterMapping->at(otherCase);
+        return color != other;
     }
 
-    // Neither given, nor otherCase has been found: needs to be added
+    // Neither the letter, nor its other case has been bound: bind it
 
-    if (isTypeB)
+    if (op.typeB)
     {
         // make sure no other letter is pointing to that color
-        for (auto it : *letterMapping)
-        {
-            if (it.second == color && tolower(it.first) >= 109) return false;
-        }
+        if (binding->typeBColors & colorBit(color)) return false;
+        binding->typeBColors |= colorBit(color);
     }
 
-    letterMapping->insert(std::pair<char, Color>(given, color));
+    binding->colors[op.letter] = color;
     return true;
 }
 
-bool stickerMatches(const Color &color, const char &match,
-    std::map<char, Color> *letterMapping)
+static bool stickerMatches(const Color &color, const PatternOp &op,
+    LetterBinding *binding)
 {
-    // Returns true if <match> (a character from the regex) matches color <color>
-    // according to <letterMapping>. If <letterMapping> does not include that
-    // character, it will be added. False is returned only when the pair
-    // (<match>, <color>) conflicts with the data in <letterMapping>.
+    // Returns true if op (a character from the pattern) matches color
+    // according to binding. If the letter of op is not bound yet, it will be.
+    // False is returned only when the pair (op, color) conflicts with the
+    // data in binding.
 
-    switch (match)
+    switch (op.kind)
     {
-        case '*':
-            return true;
-
-        case 'W':
-        case 'Y':
-        case 'G':
-        case 'B':
-        case 'R':
-        case 'O':
-            return color == static_cast<Color>(tolower(match));
-
-        case 'w':
-        case 'y':
-        case 'g':
-        case 'b':
-        case 'r':
-        case 'o':
-            return color != static_cast<Color>(match);
-
-        case 'A':
-        case 'C':
-        case 'D':
-        case 'E':
-        case 'F':
-        case 'H':
-        case 'I':
-        case 'J':
-        case 'K':
-        case 'L':
-        case 'M':
-        case 'N':
-        case 'P':
-        case 'Q':
-        case 'S':
-        case 'T':
-        case 'U':
-        case 'V':
-        case 'X':
-        case 'Z':
-            return handleLetters(color, match, tolower(match), letterMapping);
-        
-        case 'a':
-        case 'c':
-        case 'd':
-        case 'e':
-        case 'f':
-        case 'h':
-        case 'i':
-        case 'j':
-        case 'k':
-        case 'l':
-        case 'm':
-        case 'n':
-        case 'p':
-        case 'q':
-        case 's':
-        case 't':
-        case 'u':
-        case 'v':
-        case 'x':
-        case 'z':
-            return handleLetters(color, match, toupper(match), letterMapping);
-        
+        case PatternOp::ANY: return true;
+        case PatternOp::IS: return color == op.color;
+        case PatternOp::IS_NOT: return color != op.color;
+        case PatternOp::LETTER: return handleLetters(color, op, binding);
         default: return false;
     }
 }
 
+// The step by which a clockwise turn of a layer rotates its blocks (as in
+// rcube::Coordinates::rotate): M turns like L, E like D and S like F
+static int turnStep(const rcube::Orientation &layer)
+{
+    if (layer.direction != 0) return layer.direction;
+    return layer.axis == Axis::Z ? 1 : -1;
+}
+
+// Returns how many clockwise turns of layer (1 to 4) bring the block at pos to
+// dest, with its sticker facing stk ending up facing orient (any orientation
+// if orient is nullptr). Returns 0 if no number of turns does. The cube is not
+// moved: the block is followed through its coordinates.
+static int turnsToDest(const rcube::Orientation &layer, rcube::Coordinates pos,
+    rcube::Orientation stk, const rcube::Coordinates &dest,
+    const rcube::Orientation *orient)
+{
+    int step = turnStep(layer);
+    for (int turns = 1; turns <= 4; ++turns)
+    {
+        pos.rotate(layer.axis, step);
+        stk.rotate(layer.axis, step);
+
+        if (pos == dest && (orient == nullptr || stk == *orient)) return turns;
+    }
+    return 0;
+}
+
+// Turns layer clockwise the given number of times (with a single move) and
+// pushes that move to algo, if it is not nullptr
+static void turnLayer(rcube::Cube *cube, const rcube::Orientation &layer,
+    int turns, rcube::Algorithm *algo)
+{
+    turns %= 4;
+    if (turns == 3) turns = -1;
+
+    if (turns != 0) cube->performMove(rcube::Move(layer, turns));
+    if (algo != nullptr) algo->push(rcube::Move(layer, turns));
+}
+
 int getCharPos(const rcube::Coordinates2D &coords)
 {
     // Maps 2D coordinates of a face to indices in a faceMatches regex
@@ -144,14 +240,18 @@ bool rcube::Cube::faceMatches (
     rcube::Algorithm *algo
 )
 {
+    updateBlocks();
+
     // check the syntax
-    if (expr.size() != 9) return false;
+    const CompiledPattern &pattern = compilePattern(expr);
+    if (pattern.size != 9) return false;
+    const PatternOp *ops = pattern.ops;
 
     // stores which color each letter represents
-    std::map<char, Color> letterMapping;
+    LetterBinding letterMapping;
 
     // check the center
-    if (!stickerMatches(getCenterFrom(face)->color, expr[4], &letterMapping))
+    if (!stickerMatches(getCenterFrom(face)->color, ops[4], &letterMapping))
         return false;
 
 
@@ -160,7 +260,7 @@ bool rcube::Cube::faceMatches (
         letterMapping.clear();
 
         // if the center is a letter, it must be reincluded in the map
-        stickerMatches(getCenterFrom(face)->color, expr[4], &letterMapping);
+        stickerMatches(getCenterFrom(face)->color, ops[4], &letterMapping);
 
         rcube::Corner *first; // Pointer to the corner corresponding to expr[0]
 
@@ -175,7 +275,7 @@ bool rcube::Cube::faceMatches (
                 patternCoords.rotate(rot);
 
                 if (!stickerMatches(edges[i].stickers[k].color,
-                    expr[getCharPos(patternCoords)], &letterMapping))
+                    ops[getCharPos(patternCoords)], &letterMapping))
                         goto nextIt;
             }
 
@@ -195,7 +295,7 @@ bool rcube::Cube::faceMatches (
                 if (pos == 0) first = corners + i;
 
                 if (!stickerMatches(corners[i].stickers[k].color,
-                    expr[pos], &letterMapping))
+                    ops[pos], &letterMapping))
                         goto nextIt;
             }
         }
@@ -205,19 +305,17 @@ bool rcube::Cube::faceMatches (
         {
             if (dest.coords[face.axis] != face.direction) return true;
 
-            rcube::Move mv(face, 1);
+            // follow <first> until it reaches dest, then turn the face once
+            rcube::Coordinates pos = first->location;
+            int step = turnStep(face);
 
             int i = 0;
-            for (; i < 4; ++i) // Apply move until desired position is reached
+            for (; i < 4; ++i)
             {
-                if (first->location == dest) break;
-                performMove(mv);
-            }
-            if (algo != nullptr)
-            {
-                if (i == 3) i = -1;
-                algo->push(rcube::Move(face, i));
+                if (pos == dest) break;
+                pos.rotate(face.axis, step);
             }
+            turnLayer(this, face, i, algo);
         }
 
         return true;
@@ -237,11 +335,12 @@ struct MatchingPath
     rcube::Orientation _layer;
     rcube::Orientation _facesOrder[4];
 
-    std::map<char, Color> _letterMapping; // gets fed to stickerMatches()
+    LetterBinding _letterMapping; // gets fed to stickerMatches()
 
+    MatchingPath() = default;
     MatchingPath(const rcube::Coordinates &startBlock, const rcube::Orientation
         &startStk, const rcube::Orientation &layer,
-        const std::map<char, Color> &lm);
+        const LetterBinding &lm);
 
     // get the distance of a block from the starting point
     int getBlockNum(const rcube::Coordinates &blockPos,
@@ -252,7 +351,7 @@ struct MatchingPath
 
 MatchingPath::MatchingPath(const rcube::Coordinates &startBlock, const
     rcube::Orientation &startStk, const rcube::Orientation &layer,
-        const std::map<char, Color> &lm)
+        const LetterBinding &lm)
 {
     _startBlock = startBlock;
     _layer = layer;
@@ -278,6 +377,33 @@ MatchingPath::MatchingPath(const rcube::Coordinates &startBlock, const
     _facesOrder[3] = {_facesOrder[1].axis, -_facesOrder[1].direction};
 }
 
+// The paths that can still match, in the order they were found. A path starts
+// from a sticker of a corner (or of an edge for central layers) of the layer,
+// so there are at most 8 of them.
+class PathList
+{
+public:
+    void push_back(const MatchingPath &path)
+    {
+        if (_size < 8) _paths[_size++] = path;
+    }
+
+    void erase(int idx)
+    {
+        for (int i = idx; i < _size - 1; ++i) _paths[i] = _paths[i + 1];
+        --_size;
+    }
+
+    int size() const { return _size; }
+    MatchingPath& operator[](int idx) { return _paths[idx]; }
+    const MatchingPath* begin() const { return _paths; }
+    const MatchingPath* end() const { return _paths + _size; }
+
+private:
+    MatchingPath _paths[8];
+    int _size = 0;
+};
+
 int MatchingPath::getBlockNum(const rcube::Coordinates &blockPos,
     const rcube::Orientation &stk)
 {
@@ -316,10 +442,14 @@ bool rcube::Cube::layerMatches(
     rcube::Algorithm *algo
 )
 {
-    if (expr.size() != 12) return false;
+    updateBlocks();
+
+    const CompiledPattern &pattern = compilePattern(expr);
+    if (pattern.size != 12) return false;
+    const PatternOp *ops = pattern.ops;
 
-    std::vector<MatchingPath> possiblePaths;
-    std::map<char, Color> lmTmp;
+    PathList possiblePaths;
+    LetterBinding lmTmp;
 
     // central and lateral layer are two different cases
     if (layer.direction == 0)
@@ -331,7 +461,7 @@ bool rcube::Cube::layerMatches(
 
             for (int k = 0; k < 2; ++k)
             {
-                if (stickerMatches(edges[i].stickers[k].color, expr[0], &lmTmp))
+                if (stickerMatches(edges[i].stickers[k].color, ops[0], &lmTmp))
                 {
                     possiblePaths.push_back(MatchingPath(edges[i].location,
                     edges[i].stickers[k].orientation, layer, lmTmp));
@@ -349,11 +479,11 @@ bool rcube::Cube::layerMatches(
 
             for (int x = 0; x < possiblePaths.size();)
             {
-                if (!stickerMatches(centers[i].color, expr[possiblePaths[x]
+                if (!stickerMatches(centers[i].color, ops[possiblePaths[x]
                     .getBlockNum(centers[i].location, centers[i].orientation)],
                     &possiblePaths[x]._letterMapping))
                 {
-                    possiblePaths.erase(possiblePaths.begin() + x);
+                    possiblePaths.erase(x);
                     continue;
                 }
                 ++x;
@@ -367,12 +497,12 @@ bool rcube::Cube::layerMatches(
             {
                 for (int x = 0; x < possiblePaths.size();)
                 {
-                    if (!stickerMatches(edges[i].stickers[k].color, expr[
+                    if (!stickerMatches(edges[i].stickers[k].color, ops[
                         possiblePaths[x].getBlockNum(edges[i].location,
                         edges[i].stickers[k].orientation)],
                         &possiblePaths[x]._letterMapping))
                     {
-                        possiblePaths.erase(possiblePaths.begin() + x);
+                        possiblePaths.erase(x);
                         continue;
                     }
                     ++x;
@@ -387,8 +517,7 @@ bool rcube::Cube::layerMatches(
 
         // move the first edge to the desired position (if given)
 
-        rcube::Move mv(layer, 1);
-        int moveCount = 0;
+        bool anyOrient = orient == (rcube::Orientation){Axis::X, 0};
 
         for (int i = 0; i < 12; ++i)
         {
@@ -399,38 +528,19 @@ bool rcube::Cube::layerMatches(
             // first edge not aligning correctly with with <orient>. If one
             // satisfies this condition, it will be chosen
 
-            for (auto path : possiblePaths)
+            for (const MatchingPath &path : possiblePaths)
             {
                 if (edges[i].location != path._startBlock) continue;
 
-                rcube::Sticker *startStk; // sticker corresponding to expr[1]
-                for (int x = 0; x < 2; ++x)
-                {
-                    if (edges[i].stickers[x].orientation == path._facesOrder[0])
-                        startStk = edges[i].stickers + x;
-                }
-
-                for (int x = 0; x < 4; ++x)
-                {
-                    performMove(mv);
-                    moveCount++;
-
-                    if (edges[i].location != dest) continue;
+                // path._facesOrder[0] is the orientation of the sticker
+                // corresponding to expr[1]
+                int turns = turnsToDest(layer, edges[i].location,
+                    path._facesOrder[0], dest, anyOrient ? nullptr : &orient);
+                if (turns == 0) continue;
 
-                    if (orient == (rcube::Orientation){Axis::X, 0})
-                        return true;
-                    
-                    if (startStk->orientation == orient)
-                    {
-                        if (algo != nullptr)
-                        {
-                            moveCount = moveCount % 4;
-                            if (moveCount == 3) moveCount = -1;
-                            algo->push(rcube::Move(layer, moveCount));
-                        }
-                        return true;
-                    }
-                }
+                // the moves are not pushed when any orientation is fine
+                turnLayer(this, layer, turns, anyOrient ? nullptr : algo);
+                return true;
             }
         }
         return false;
@@ -448,7 +558,7 @@ bool rcube::Cube::layerMatches(
         {
             if (corners[i].stickers[k].orientation == layer) continue;
 
-            if (stickerMatches(corners[i].stickers[k].color, expr[0], &lmTmp))
+            if (stickerMatches(corners[i].stickers[k].color, ops[0], &lmTmp))
             {
                 possiblePaths.push_back(MatchingPath(corners[i].location,
                     corners[i].stickers[k].orientation, layer, lmTmp));
@@ -469,12 +579,12 @@ bool rcube::Cube::layerMatches(
 
                 for (int x = 0; x < possiblePaths.size();)
                 {
-                    if (!stickerMatches(edges[i].stickers[k].color, expr[
+                    if (!stickerMatches(edges[i].stickers[k].color, ops[
                         possiblePaths[x].getBlockNum(edges[i].location,
                         edges[i].stickers[k].orientation)],
                         &possiblePaths[x]._letterMapping))
                     {
-                        possiblePaths.erase(possiblePaths.begin() + x);
+                        possiblePaths.erase(x);
                         continue;
                     }
                     ++x;
@@ -493,12 +603,12 @@ bool rcube::Cube::layerMatches(
 
             for (int x = 0; x < possiblePaths.size();)
             {
-                if (!stickerMatches(corners[i].stickers[k].color, expr[
+                if (!stickerMatches(corners[i].stickers[k].color, ops[
                     possiblePaths[x].getBlockNum(corners[i].location,
                     corners[i].stickers[k].orientation)],
                     &possiblePaths[x]._letterMapping))
                 {
-                    possiblePaths.erase(possiblePaths.begin() + x);
+                    possiblePaths.erase(x);
                     continue;
                 }
                 ++x;
@@ -513,43 +623,22 @@ bool rcube::Cube::layerMatches(
 
     // move the first block to the desired position
 
-    rcube::Move mv(layer, 1);
-    int moveCount = 0;
-
     for (int i = 0; i < 8; ++i)
     {
         if (corners[i].location.coords[layer.axis] != layer.direction) continue;
 
-        for (auto path : possiblePaths)
+        for (const MatchingPath &path : possiblePaths)
         {
             if (corners[i].location != path._startBlock) continue;
 
-            rcube::Sticker *startStk; // sticker corresponding to expr[0]
-            for (int x = 0; x < 3; ++x)
-            {
-                if (corners[i].stickers[x].orientation == path._facesOrder[0])
-                {
-                    startStk = corners[i].stickers + x;
-                }
-            }
-
-            for (int x = 0; x < 4; ++x)
-            {
-                performMove(mv);
-                moveCount++;
-                if (corners[i].location != dest) continue;
+            // path._facesOrder[0] is the orientation of the sticker
+            // corresponding to expr[0]
+            int turns = turnsToDest(layer, corners[i].location,
+                path._facesOrder[0], dest, &orient);
+            if (turns == 0) continue;
 
-                if (startStk->orientation == orient)
-                {
-                    if (algo != nullptr)
-                    {
-                        moveCount = moveCount % 4;
-                        if (moveCount == 3) moveCount = -1;
-                        algo->push(rcube::Move(layer, moveCount));
-                    }
-                    return true;
-                }
-            }
+            turnLayer(this, layer, turns, algo);
+            return true;
         }
     }
     return false;
@@ -563,14 +652,17 @@ bool rcube::Cube::layerAndFaceMatch(
     rcube::Algorithm *algo
 )
 {
-    if (expr.size() != 22 || layer.direction == 0) return false;
+    updateBlocks();
+
+    const CompiledPattern &pattern = compilePattern(expr);
+    if (pattern.size != 22 || layer.direction == 0) return false;
 
-    std::string faceExpr = expr.substr(0, 9);
-    std::string layerExpr = expr.substr(10, 12);
+    const PatternOp *faceExpr = pattern.ops;
+    const PatternOp *layerExpr = pattern.ops + 10;
 
     // The code is very similar to layerMatches
-    std::vector<MatchingPath> possiblePaths;
-    std::map<char, Color> lmTmp;
+    PathList possiblePaths;
+    LetterBinding lmTmp;
 
     // check the center
     if (!stickerMatches(getCenterFrom(layer)->color, faceExpr[4], &lmTmp))
@@ -646,7 +738,7 @@ bool rcube::Cube::layerAndFaceMatch(
                     ++x;
                     continue;
                 }
-                possiblePaths.erase(possiblePaths.begin() + x);
+                possiblePaths.erase(x);
             }
         }
         }
@@ -680,7 +772,7 @@ bool rcube::Cube::layerAndFaceMatch(
                     ++x;
                     continue;
                 }
-                possiblePaths.erase(possiblePaths.begin() + x);
+                possiblePaths.erase(x);
             }
         }
     }
@@ -692,43 +784,22 @@ bool rcube::Cube::layerAndFaceMatch(
 
     // move the first block to the desired position
 
-    rcube::Move mv(layer, 1);
-    int moveCount = 0;
-
     for (int i = 0; i < 8; ++i)
     {
         if (corners[i].location.coords[layer.axis] != layer.direction) continue;
 
-        for (auto path : possiblePaths)
+        for (const MatchingPath &path : possiblePaths)
         {
             if (corners[i].location != path._startBlock) continue;
 
-            rcube::Sticker *startStk; // sticker corresponding to expr[1]
-            for (int x = 0; x < 3; ++x)
-            {
-                if (corners[i].stickers[x].orientation == path._facesOrder[0])
-                {
-                    startStk = corners[i].stickers + x;
-                }
-            }
-
-            for (int x = 0; x < 4; ++x)
-            {
-                performMove(mv);
-                moveCount++;
-                if (corners[i].location != dest) continue;
+            // path._facesOrder[0] is the orientation of the sticker
+            // corresponding to expr[1]
+            int turns = turnsToDest(layer, corners[i].location,
+                path._facesOrder[0], dest, &orient);
+            if (turns == 0) continue;
 
-                if (startStk->orientation == orient)
-                {
-                    if (algo != nullptr)
-                    {
-                        moveCount = moveCount % 4;
-                        if (moveCount == 3) moveCount = -1;
-                        algo->push(rcube::Move(layer, moveCount));
-                    }
-                    return true;
-                }
-            }
+            turnLayer(this, layer, turns, algo);
+            return true;
         }
     }
     return false;
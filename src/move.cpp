@@ -21,18 +21,24 @@ Axis getAxis(const MoveFace& face)
     case RIGHT:
     case ROTATE_X:
     case MIDDLE:
+    case LEFT_W:
+    case RIGHT_W:
       return Axis::X;
 
     case UP:
     case DOWN:
     case ROTATE_Y:
     case EQUATOR:
+    case UP_W:
+    case DOWN_W:
       return Axis::Y;
 
     case FRONT:
     case BACK:
     case ROTATE_Z:
     case SIDE:
+    case FRONT_W:
+    case BACK_W:
       return Axis::Z;
   }
 }
@@ -130,4 +136,14 @@ rcube::Orientation rcube::Move::getAffectedFace() const
 rcube::Move rcube::Move::getInverted() const
 {
   return rcube::Move(face, -direction);
-}
\ No newline at end of file
+}
+
+bool rcube::Move::operator==(const rcube::Move &m) const
+{
+  return face == m.face && direction == m.direction;
+}
+
+bool rcube::Move::operator!=(const rcube::Move &m) const
+{
+  return !(*this == m);
+}
@@ -0,0 +1,171 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#include <cstring>
+#include <type_traits>
+
+#include <rcube.hpp>
+
+static_assert(std::is_trivially_copyable<rcube::Move>::value,
+    "rcube::MoveVector copies moves with memcpy");
+
+rcube::MoveVector::MoveVector()
+{
+    ptr = reinterpret_cast<rcube::Move*>(buffer);
+    count = 0;
+    cap = INLINE_SIZE;
+}
+
+rcube::MoveVector::MoveVector(const std::vector<rcube::Move> &moves)
+    : MoveVector()
+{
+    reserve(moves.size());
+    if (!moves.empty())
+        std::memcpy(ptr, moves.data(), moves.size() * sizeof(rcube::Move));
+    count = moves.size();
+}
+
+rcube::MoveVector::MoveVector(const rcube::MoveVector &v) : MoveVector()
+{
+    *this = v;
+}
+
+rcube::MoveVector::MoveVector(rcube::MoveVector &&v) noexcept : MoveVector()
+{
+    *this = std::move(v);
+}
+
+rcube::MoveVector::~MoveVector()
+{
+    if (ptr != reinterpret_cast<rcube::Move*>(buffer))
+        delete[] reinterpret_cast<unsigned char*>(ptr);
+}
+
+rcube::MoveVector& rcube::MoveVector::operator=(const rcube::MoveVector &v)
+{
+    if (this == &v) return *this;
+
+    count = 0;
+    reserve(v.count);
+    if (v.count > 0)
+        std::memcpy(ptr, v.ptr, v.count * sizeof(rcube::Move));
+    count = v.count;
+    return *this;
+}
+
+rcube::MoveVector& rcube::MoveVector::operator=(rcube::MoveVector &&v) noexcept
+{
+    if (this == &v) return *this;
+
+    // inline moves have to be copied, heap buffers can just be stolen. Neither
+    // allocates: the capacity is never smaller than INLINE_SIZE
+    if (v.ptr == reinterpret_cast<rcube::Move*>(v.buffer))
+    {
+        if (v.count > 0)
+            std::memcpy(ptr, v.ptr, v.count * sizeof(rcube::Move));
+        count = v.count;
+        return *this;
+    }
+
+    if (ptr != reinterpret_cast<rcube::Move*>(buffer))
+        delete[] reinterpret_cast<unsigned char*>(ptr);
+    ptr = v.ptr;
+    count = v.count;
+    cap = v.cap;
+
+    v.ptr = reinterpret_cast<rcube::Move*>(v.buffer);
+    v.count = 0;
+    v.cap = INLINE_SIZE;
+    return *this;
+}
+
+rcube::MoveVector::operator std::vector<rcube::Move>() const
+{
+    return std::vector<rcube::Move>(begin(), end());
+}
+
+void rcube::MoveVector::reserve(size_type n)
+{
+    if (n <= cap) return;
+
+    size_type newCap = cap;
+    while (newCap < n) newCap *= 2;
+
+    // rcube::Move has no default constructor, so raw memory is used
+    rcube::Move *newPtr = reinterpret_cast<rcube::Move*>(
+        new unsigned char[newCap * sizeof(rcube::Move)]);
+    if (count > 0) std::memcpy(newPtr, ptr, count * sizeof(rcube::Move));
+
+    if (ptr != reinterpret_cast<rcube::Move*>(buffer))
+        delete[] reinterpret_cast<unsigned char*>(ptr);
+    ptr = newPtr;
+    cap = newCap;
+}
+
+rcube::MoveVector::iterator rcube::MoveVector::insert(const_iterator pos,
+    const rcube::Move &m)
+{
+    return insert(pos, &m, &m + 1);
+}
+
+rcube::MoveVector::iterator rcube::MoveVector::insert(const_iterator pos,
+    const_iterator first, const_iterator last)
+{
+    size_type index = pos - ptr;
+    size_type n = last - first;
+    if (n == 0) return ptr + index;
+
+    // the range may be moved by reserve() if it is inside this vector
+    if (first >= ptr && first < ptr + count)
+    {
+        rcube::MoveVector tmp;
+        tmp.insert(tmp.end(), first, last);
+        return insert(ptr + index, tmp.begin(), tmp.end());
+    }
+
+    reserve(count + n);
+    std::memmove(ptr + index + n, ptr + index,
+        (count - index) * sizeof(rcube::Move));
+    std::memcpy(ptr + index, first, n * sizeof(rcube::Move));
+    count += n;
+    return ptr + index;
+}
+
+rcube::MoveVector::iterator rcube::MoveVector::erase(const_iterator pos)
+{
+    return erase(pos, pos + 1);
+}
+
+rcube::MoveVector::iterator rcube::MoveVector::erase(const_iterator first,
+    const_iterator last)
+{
+    size_type index = first - ptr;
+    size_type n = last - first;
+
+    std::memmove(ptr + index, ptr + index + n,
+        (count - index - n) * sizeof(rcube::Move));
+    count -= n;
+    return ptr + index;
+}
+
+bool rcube::MoveVector::operator==(const rcube::MoveVector &v) const
+{
+    if (count != v.count) return false;
+
+    for (size_type i = 0; i < count; ++i)
+    {
+        if (ptr[i] != v.ptr[i]) return false;
+    }
+    return true;
+}
+
+bool rcube::MoveVector::operator!=(const rcube::MoveVector &v) const
+{
+    return !(*this == v);
+}
@@ -0,0 +1,295 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+
+#include <rcube.hpp>
+#include <utility.hpp>
+
+// the table stores an optimal sequence for every state that can be reached
+// with up to TABLE_DEPTH moves, so windows of up to 2 * TABLE_DEPTH moves can
+// be solved optimally by splitting them in two halves
+#define TABLE_DEPTH 4
+#define MAX_WINDOW (2 * TABLE_DEPTH)
+
+// the 18 outer layer moves: move index = face * 3 + (0: CW, 1: DOUBLE, 2: CCW)
+// and opposite faces only differ in the lowest bit
+static const MoveFace optFaces[6] = {RIGHT, LEFT, UP, DOWN, FRONT, BACK};
+static const MoveDirection optDirections[3] = {CW, DOUBLE, CCW};
+
+static int moveIndex(const rcube::Move &move)
+{
+    int face = -1;
+    for (int i = 0; i < 6; ++i)
+        if (optFaces[i] == move.face) face = i;
+
+    if (face == -1) return -1;
+    return face * 3 + (move.direction == CW ? 0 :
+        move.direction == DOUBLE ? 1 : 2);
+}
+
+// a sequence of up to 5 moves is encoded in 32 bits: 3 bits for the length,
+// then 5 bits for each move
+typedef uint32_t SeqCode;
+
+static int codeLength(SeqCode code) { return code & 7; }
+static int codeMove(SeqCode code, int i) { return (code >> (3 + 5 * i)) & 31; }
+static SeqCode codePush(SeqCode code, int move)
+{
+    int len = codeLength(code);
+    return ((code & ~7u) | (move << (3 + 5 * len))) | (len + 1);
+}
+
+static void pushCode(rcube::Algorithm &dest, SeqCode code)
+{
+    for (int i = 0; i < codeLength(code); ++i)
+    {
+        int m = codeMove(code, i);
+        dest.push(rcube::Move(optFaces[m / 3], optDirections[m % 3]));
+    }
+}
+
+struct StateHash
+{
+    size_t operator()(const rcube::PackedState &state) const
+    {
+        return state.getHash();
+    }
+};
+
+struct OptimalTable
+{
+    // the states of the 18 moves, by move index
+    rcube::PackedState moves[18];
+
+    // shortest sequence for each state reachable within TABLE_DEPTH moves
+    std::unordered_map<rcube::PackedState, SeqCode, StateHash> shortest;
+
+    // the states at exactly d moves from a solved cube (d < TABLE_DEPTH) with
+    // their inverses, used as the first half of longer sequences
+    struct Prefix
+    {
+        rcube::PackedState inverse;
+        SeqCode code;
+    };
+    std::vector<Prefix> prefixes[TABLE_DEPTH];
+
+    OptimalTable();
+};
+
+OptimalTable::OptimalTable()
+{
+    for (int m = 0; m < 18; ++m)
+    {
+        moves[m] = rcube::PackedState::getMoveState(
+            rcube::Move(optFaces[m / 3], optDirections[m % 3]));
+    }
+
+    std::vector<std::pair<rcube::PackedState, SeqCode>> level, next;
+    level.push_back({rcube::PackedState(), 0});
+    shortest[rcube::PackedState()] = 0;
+
+    for (int depth = 0; depth <= TABLE_DEPTH; ++depth)
+    {
+        if (depth < TABLE_DEPTH)
+        {
+            for (const auto &entry : level)
+                prefixes[depth].push_back({entry.first.getInverse(),
+                    entry.second});
+        }
+        if (depth == TABLE_DEPTH) break;
+
+        next.clear();
+        for (const auto &entry : level)
+        {
+            int len = codeLength(entry.second);
+            int last = len ? codeMove(entry.second, len - 1) / 3 : -1;
+
+            for (int m = 0; m < 18; ++m)
+            {
+                // turning the same face twice in a row never gives a new
+                // shortest sequence
+                if (m / 3 == last) continue;
+
+                rcube::PackedState state = entry.first * moves[m];
+                if (shortest.count(state)) continue;
+
+                SeqCode code = codePush(entry.second, m);
+                shortest[state] = code;
+                next.push_back({state, code});
+            }
+        }
+        level.swap(next);
+    }
+}
+
+static const OptimalTable& getOptimalTable()
+{
+    static const OptimalTable table;
+    return table;
+}
+
+// Looks for a sequence shorter than maxLength moves that reaches state from a
+// solved cube. Returns false if there is none.
+static bool findShorter(const rcube::PackedState &state, int maxLength,
+    SeqCode *prefix, SeqCode *suffix)
+{
+    const OptimalTable &table = getOptimalTable();
+
+    auto it = table.shortest.find(state);
+    if (it != table.shortest.end())
+    {
+        if (codeLength(it->second) >= maxLength) return false;
+        *prefix = 0;
+        *suffix = it->second;
+        return true;
+    }
+
+    // an optimal sequence of d > TABLE_DEPTH moves starts with an optimal
+    // sequence of d - TABLE_DEPTH moves and ends with one of TABLE_DEPTH moves
+    for (int d = TABLE_DEPTH + 1; d < maxLength; ++d)
+    {
+        for (const OptimalTable::Prefix &p : table.prefixes[d - TABLE_DEPTH])
+        {
+            auto found = table.shortest.find(p.inverse * state);
+            if (found == table.shortest.end()) continue;
+
+            *prefix = p.code;
+            *suffix = found->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct Replacement
+{
+    int start;
+    int length; // of the replaced window
+    SeqCode prefix;
+    SeqCode suffix;
+
+    int gain() const
+    {
+        return length - codeLength(prefix) - codeLength(suffix);
+    }
+};
+
+// Finds the window starting at start whose replacement saves the most moves
+static Replacement bestReplacement(const std::vector<int> &moves, int start)
+{
+    const OptimalTable &table = getOptimalTable();
+
+    Replacement best = {start, 0, 0, 0};
+    rcube::PackedState state;
+
+    for (int len = 1; len <= MAX_WINDOW; ++len)
+    {
+        int m = moves[start + len - 1];
+        if (m == -1) break;
+        state.multiply(table.moves[m]);
+
+        Replacement r = {start, len, 0, 0};
+        if (findShorter(state, len, &r.prefix, &r.suffix) &&
+            r.gain() > best.gain())
+            best = r;
+    }
+    return best;
+}
+
+void rcube::Algorithm::optimize(int threads, int timeout)
+{
+    getOptimalTable(); // built before the threads are started
+
+    auto deadline = std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(timeout);
+    if (threads < 1) threads = 1;
+
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        // moves other than R, L, U, D, F and B are not optimized and split
+        // the algorithm into independent segments (-1 = not optimized); the
+        // list is padded so that windows never read past its end
+        std::vector<int> moves;
+        for (const rcube::Move &m : algorithm) moves.push_back(moveIndex(m));
+        moves.insert(moves.end(), MAX_WINDOW, -1);
+
+        // every window start is evaluated independently
+        std::vector<Replacement> found(length());
+        std::vector<std::thread> workers;
+
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]() {
+                for (int i = t; i < length(); i += threads)
+                {
+                    if (std::chrono::steady_clock::now() >= deadline) break;
+                    if (moves[i] == -1) found[i] = {i, 0, 0, 0};
+                    else found[i] = bestReplacement(moves, i);
+                }
+            });
+        }
+        for (std::thread &worker : workers) worker.join();
+
+        // windows that did not get evaluated in time are left as they are
+        std::vector<Replacement> chosen;
+        for (int i = 0; i < length(); ++i)
+            if (found[i].length > 0 && found[i].gain() > 0)
+                chosen.push_back(found[i]);
+
+        if (chosen.empty()) break;
+
+        // the replacements that save the most moves are applied first, if
+        // they do not overlap with the ones already applied
+        std::stable_sort(chosen.begin(), chosen.end(),
+            [](const Replacement &a, const Replacement &b) {
+                return a.gain() > b.gain();
+            });
+
+        std::vector<const Replacement*> at(length(), nullptr);
+        std::vector<bool> used(length(), false);
+        for (const Replacement &r : chosen)
+        {
+            bool free = true;
+            for (int i = r.start; i < r.start + r.length; ++i)
+                if (used[i]) free = false;
+
+            if (!free) continue;
+            for (int i = r.start; i < r.start + r.length; ++i) used[i] = true;
+            at[r.start] = &r;
+        }
+
+        rcube::Algorithm res;
+        res.reserve(length());
+        for (int i = 0; i < length();)
+        {
+            if (at[i] == nullptr)
+            {
+                res.push(algorithm[i++]);
+                continue;
+            }
+
+            pushCode(res, at[i]->prefix);
+            pushCode(res, at[i]->suffix);
+            i += at[i]->length;
+        }
+        algorithm = std::move(res.algorithm);
+    }
+}
+
+rcube::Algorithm rcube::Algorithm::optimized(int threads, int timeout) const
+{
+    rcube::Algorithm res = *this;
+    res.optimize(threads, timeout);
+    return res;
+}
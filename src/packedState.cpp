@@ -0,0 +1,502 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+#include <rcube.hpp>
+#include <utility.hpp>
+
+#define U_FACE {Axis::Y, 1}
+#define D_FACE {Axis::Y, -1}
+#define R_FACE {Axis::X, 1}
+#define L_FACE {Axis::X, -1}
+#define F_FACE {Axis::Z, 1}
+#define B_FACE {Axis::Z, -1}
+
+// UR, UF, UL, UB, DR, DF, DL, DB, FR, FL, BL, BR
+const rcube::Orientation rcube::PackedState::edgeFaces[12][2] = {
+    {U_FACE, R_FACE}, {U_FACE, F_FACE}, {U_FACE, L_FACE}, {U_FACE, B_FACE},
+    {D_FACE, R_FACE}, {D_FACE, F_FACE}, {D_FACE, L_FACE}, {D_FACE, B_FACE},
+    {F_FACE, R_FACE}, {F_FACE, L_FACE}, {B_FACE, L_FACE}, {B_FACE, R_FACE}
+};
+
+// URF, UFL, ULB, UBR, DFR, DLF, DBL, DRB
+const rcube::Orientation rcube::PackedState::cornerFaces[8][3] = {
+    {U_FACE, R_FACE, F_FACE}, {U_FACE, F_FACE, L_FACE},
+    {U_FACE, L_FACE, B_FACE}, {U_FACE, B_FACE, R_FACE},
+    {D_FACE, F_FACE, R_FACE}, {D_FACE, L_FACE, F_FACE},
+    {D_FACE, B_FACE, L_FACE}, {D_FACE, R_FACE, B_FACE}
+};
+
+// the layers turned by each move stored in MoveTables, in the same order: a
+// clockwise quarter turn rotates the layers from minLayer to maxLayer along
+// axis by step (as in rcube::Orientation::rotate)
+struct MoveSpec
+{
+    MoveFace face;
+    Axis axis;
+    int step;
+    int minLayer;
+    int maxLayer;
+};
+
+static const MoveSpec tableMoves[] = {
+    {RIGHT, Axis::X, 1, 1, 1},
+    {LEFT, Axis::X, -1, -1, -1},
+    {UP, Axis::Y, 1, 1, 1},
+    {DOWN, Axis::Y, -1, -1, -1},
+    {FRONT, Axis::Z, 1, 1, 1},
+    {BACK, Axis::Z, -1, -1, -1},
+
+    // the rotations of the whole cube turn like R, U and F
+    {ROTATE_X, Axis::X, 1, -1, 1},
+    {ROTATE_Y, Axis::Y, 1, -1, 1},
+    {ROTATE_Z, Axis::Z, 1, -1, 1},
+
+    // M turns like L, E like D and S like F
+    {MIDDLE, Axis::X, -1, 0, 0},
+    {EQUATOR, Axis::Y, -1, 0, 0},
+    {SIDE, Axis::Z, 1, 0, 0},
+
+    {RIGHT_W, Axis::X, 1, 0, 1},
+    {LEFT_W, Axis::X, -1, -1, 0},
+    {UP_W, Axis::Y, 1, 0, 1},
+    {DOWN_W, Axis::Y, -1, -1, 0},
+    {FRONT_W, Axis::Z, 1, 0, 1},
+    {BACK_W, Axis::Z, -1, -1, 0}
+};
+#define N_TABLE_MOVES ((int)(sizeof(tableMoves) / sizeof(MoveSpec)))
+
+// index of x in tableMoves (followed by y and z)
+#define FIRST_ROTATION 6
+
+struct MoveTables
+{
+    // moves[i][q] is the state of tableMoves[i] applied q times (q = 0..3)
+    rcube::PackedState moves[N_TABLE_MOVES][4];
+
+    // the 24 orientations of the whole cube and their inverses
+    rcube::PackedState rotations[24];
+    rcube::PackedState invRotations[24];
+
+    // rotationIdx[U center][F center] = index in rotations
+    int rotationIdx[6][6];
+
+    // movedSlots[i][q] = slots changed by moves[i][q] (bit i = data[i])
+    uint32_t movedSlots[N_TABLE_MOVES][4];
+
+    // faceIdx[face] = index in tableMoves (-1 for unsupported moves)
+    int faceIdx[128];
+
+    // zobrist[slot][byte] = random key used by getHash
+    uint64_t zobrist[32][64];
+
+    MoveTables();
+};
+
+int rcube::PackedState::faceIndex(const rcube::Orientation &face)
+{
+    return (int)face.axis * 2 + (face.direction + 1) / 2;
+}
+
+template<int N>
+int findSlot(const rcube::Orientation (*slotFaces)[N], int nSlots,
+    const rcube::Orientation *faces, int *ori)
+{
+    // Returns the slot adjacent to the given N faces (in any order). The index
+    // of faces[0] among the slot's faces is written to ori.
+
+    for (int s = 0; s < nSlots; ++s)
+    {
+        int matches = 0;
+        for (int j = 0; j < N; ++j)
+        {
+            for (int k = 0; k < N; ++k)
+            {
+                if (slotFaces[s][k] != faces[j]) continue;
+
+                if (j == 0) *ori = k;
+                matches++;
+            }
+        }
+        if (matches == N) return s;
+    }
+    return -1;
+}
+
+template<int N>
+void buildSlotMove(uint8_t *dest, const rcube::Orientation (*slotFaces)[N],
+    int nSlots, Axis axis, int step, int minLayer, int maxLayer)
+{
+    for (int s = 0; s < nSlots; ++s)
+    {
+        int layer = 0;
+        for (int k = 0; k < N; ++k)
+        {
+            if (slotFaces[s][k].axis == axis) layer = slotFaces[s][k].direction;
+        }
+        if (layer < minLayer || layer > maxLayer) continue;
+
+        rcube::Orientation rotated[N];
+        for (int k = 0; k < N; ++k)
+            rotated[k] = slotFaces[s][k].getRotated(axis, step);
+
+        // the piece in slot s moves to slot d, where its reference sticker
+        // lands on the ori-th face
+        int ori = 0;
+        int d = findSlot<N>(slotFaces, nSlots, rotated, &ori);
+        dest[d] = s | (ori << 4);
+    }
+}
+
+rcube::PackedState buildMove(Axis axis, int step, int minLayer, int maxLayer)
+{
+    // Builds the state of a clockwise quarter turn of the layers between
+    // minLayer and maxLayer along axis. step is the rotation direction as in
+    // rcube::Orientation::rotate.
+
+    rcube::PackedState res;
+
+    buildSlotMove<2>(res.data + rcube::PackedState::EDGES,
+        rcube::PackedState::edgeFaces, 12, axis, step, minLayer, maxLayer);
+    buildSlotMove<3>(res.data + rcube::PackedState::CORNERS,
+        rcube::PackedState::cornerFaces, 8, axis, step, minLayer, maxLayer);
+
+    std::vector<rcube::Orientation> faces = rcube::Orientation::iterate();
+    for (int f = 0; f < 6; ++f)
+    {
+        int layer = rcube::Coordinates(faces[f]).coords[axis];
+        if (layer < minLayer || layer > maxLayer) continue;
+
+        int d = rcube::PackedState::faceIndex(faces[f].getRotated(axis, step));
+        res.data[rcube::PackedState::CENTERS + d] = 8 + f;
+    }
+    return res;
+}
+
+MoveTables::MoveTables()
+{
+    for (int i = 0; i < 128; ++i) faceIdx[i] = -1;
+
+    for (int i = 0; i < N_TABLE_MOVES; ++i)
+    {
+        const MoveSpec &spec = tableMoves[i];
+        faceIdx[spec.face] = i;
+
+        moves[i][1] = buildMove(spec.axis, spec.step, spec.minLayer,
+            spec.maxLayer);
+        for (int q = 2; q < 4; ++q)
+        {
+            moves[i][q] = moves[i][q - 1];
+            moves[i][q].multiply(moves[i][1]);
+        }
+
+        for (int q = 0; q < 4; ++q)
+        {
+            movedSlots[i][q] = 0;
+            for (int k = 0; k < 32; ++k)
+            {
+                if (moves[i][q].data[k] != k % 16) movedSlots[i][q] |= 1u << k;
+            }
+        }
+    }
+
+    // the keys are generated with splitmix64 from a fixed seed, so that hashes
+    // are the same across runs
+    uint64_t seed = 0x2545f4914f6cdd1d;
+    for (int i = 0; i < 32; ++i)
+    {
+        for (int k = 0; k < 64; ++k)
+        {
+            uint64_t z = (seed += 0x9e3779b97f4a7c15);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            zobrist[i][k] = z ^ (z >> 31);
+        }
+    }
+
+    // the 24 orientations are reached through x, y and z (breadth first)
+    for (int i = 0; i < 6; ++i)
+    {
+        for (int k = 0; k < 6; ++k) rotationIdx[i][k] = -1;
+    }
+
+    const int U = rcube::PackedState::CENTERS + 3;
+    const int F = rcube::PackedState::CENTERS + 5;
+    int found = 1;
+    rotationIdx[3][5] = 0;
+
+    for (int i = 0; i < found; ++i)
+    {
+        for (int r = FIRST_ROTATION; r < FIRST_ROTATION + 3; ++r)
+        {
+            rcube::PackedState next = rotations[i];
+            next.multiply(moves[r][1]);
+
+            int u = next.data[U] - 8, f = next.data[F] - 8;
+            if (rotationIdx[u][f] != -1) continue;
+
+            rotationIdx[u][f] = found;
+            rotations[found] = next;
+            found++;
+        }
+    }
+
+    for (int i = 0; i < 24; ++i) invRotations[i] = rotations[i].getInverse();
+}
+
+static const MoveTables& getTables()
+{
+    static const MoveTables tables;
+    return tables;
+}
+
+rcube::PackedState::PackedState()
+{
+    for (int i = 0; i < 32; ++i) data[i] = i % 16;
+}
+
+void rcube::PackedState::multiply(const rcube::PackedState &t)
+{
+    // new[i] = old[t[i] & 0x0f] + (t[i] & 0x30): the edge orientation is then
+    // reduced modulo 2 (by clearing bit 5), the corner one modulo 3 (by
+    // subtracting 3 when it is >= 3, i.e. min(v, v - 0x30) on unsigned bytes)
+
+#if defined(__AVX2__)
+    const __m256i oriMask = _mm256_set1_epi8(0x30);
+    const __m256i edgeMask = _mm256_setr_epi8(
+        0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f,
+        0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i cornerMod = _mm256_setr_epi8(
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30,
+        0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30);
+
+    __m256i s = _mm256_loadu_si256((const __m256i*)data);
+    __m256i m = _mm256_loadu_si256((const __m256i*)t.data);
+
+    __m256i v = _mm256_shuffle_epi8(s, m);
+    v = _mm256_add_epi8(v, _mm256_and_si256(m, oriMask));
+    v = _mm256_and_si256(v, edgeMask);
+    v = _mm256_min_epu8(v, _mm256_sub_epi8(v, cornerMod));
+
+    _mm256_storeu_si256((__m256i*)data, v);
+
+#elif defined(__SSSE3__)
+    const __m128i oriMask = _mm_set1_epi8(0x30);
+    const __m128i edgeMask = _mm_set1_epi8(0x1f);
+
+    __m128i e = _mm_loadu_si128((const __m128i*)(data + EDGES));
+    __m128i c = _mm_loadu_si128((const __m128i*)(data + CORNERS));
+    __m128i me = _mm_loadu_si128((const __m128i*)(t.data + EDGES));
+    __m128i mc = _mm_loadu_si128((const __m128i*)(t.data + CORNERS));
+
+    e = _mm_shuffle_epi8(e, me);
+    e = _mm_add_epi8(e, _mm_and_si128(me, oriMask));
+    e = _mm_and_si128(e, edgeMask);
+
+    c = _mm_shuffle_epi8(c, mc);
+    c = _mm_add_epi8(c, _mm_and_si128(mc, oriMask));
+    c = _mm_min_epu8(c, _mm_sub_epi8(c, oriMask));
+
+    _mm_storeu_si128((__m128i*)(data + EDGES), e);
+    _mm_storeu_si128((__m128i*)(data + CORNERS), c);
+
+#else
+    uint8_t res[32];
+
+    for (int i = 0; i < 16; ++i)
+    {
+        uint8_t e = t.data[EDGES + i];
+        res[EDGES + i] = (data[EDGES + (e & 0x0f)] + (e & 0x30)) & 0x1f;
+
+        uint8_t c = t.data[CORNERS + i];
+        uint8_t v = data[CORNERS + (c & 0x0f)] + (c & 0x30);
+        res[CORNERS + i] = (v >= 0x30) ? v - 0x30 : v;
+    }
+    std::memcpy(data, res, 32);
+#endif
+}
+
+void rcube::PackedState::performMove(const rcube::Move &move)
+{
+    multiply(getMoveState(move));
+}
+
+void rcube::PackedState::performAlgorithm(const rcube::Algorithm &algo)
+{
+    for (const rcube::Move &mv : algo.algorithm)
+        multiply(getMoveState(mv));
+}
+
+rcube::PackedState rcube::PackedState::getInverse() const
+{
+    rcube::PackedState inv;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        // the piece e sits in slot i with orientation o: in the inverse, piece
+        // i sits in slot e with the opposite orientation
+        uint8_t e = data[EDGES + i];
+        inv.data[EDGES + (e & 0x0f)] = i | (e & 0x10);
+
+        uint8_t c = data[CORNERS + i];
+        int ori = (3 - (c >> 4)) % 3;
+        inv.data[CORNERS + (c & 0x0f)] = i | (ori << 4);
+    }
+    return inv;
+}
+
+rcube::PackedState rcube::PackedState::operator*(
+    const rcube::PackedState &t) const
+{
+    rcube::PackedState res = *this;
+    res.multiply(t);
+    return res;
+}
+
+std::vector<std::vector<int>> rcube::PackedState::getCycles() const
+{
+    std::vector<std::vector<int>> cycles;
+    bool visited[32] = {false};
+
+    // the slot i takes its piece from slot data[i], so following data from a
+    // slot goes backwards along the cycle
+    for (int i = 0; i < 32; ++i)
+    {
+        if (visited[i]) continue;
+
+        int lane = i & 0x10;
+        std::vector<int> cycle;
+        int ori = 0;
+
+        for (int k = i; !visited[k]; k = lane + (data[k] & 0x0f))
+        {
+            visited[k] = true;
+            cycle.push_back(k);
+            ori += data[k] >> 4;
+        }
+
+        if (cycle.size() == 1 && ori == 0) continue;
+
+        // list the slots in the order the pieces move
+        std::vector<int> forward(cycle.rbegin(), cycle.rend() - 1);
+        forward.insert(forward.begin(), cycle[0]);
+        cycles.push_back(forward);
+    }
+    return cycles;
+}
+
+static int gcd(int a, int b)
+{
+    return (b == 0) ? a : gcd(b, a % b);
+}
+
+int rcube::PackedState::getOrder() const
+{
+    int order = 1;
+
+    for (const std::vector<int> &cycle : getCycles())
+    {
+        // after going around the cycle once, each piece is back in its slot
+        // twisted by the sum of the orientations of the cycle
+        int ori = 0;
+        for (int k : cycle) ori += data[k] >> 4;
+
+        int mod = (cycle[0] < CORNERS) ? 2 : 3;
+        int len = cycle.size();
+        if (ori % mod != 0) len *= mod;
+
+        order = order / gcd(order, len) * len;
+    }
+    return order;
+}
+
+rcube::PackedState rcube::PackedState::getReoriented() const
+{
+    const MoveTables &tables = getTables();
+    int idx = tables.rotationIdx[data[CENTERS + 3] - 8][data[CENTERS + 5] - 8];
+
+    // If the current state was obtained as A * r (with r being a rotation),
+    // then r^-1 * A * r is the same state seen from the new viewpoint
+    rcube::PackedState res = tables.invRotations[idx];
+    res.multiply(*this);
+    return res;
+}
+
+const rcube::PackedState& rcube::PackedState::getMoveState(
+    const rcube::Move &move)
+{
+    const MoveTables &tables = getTables();
+    int idx = ((int)move.face & 0x7f);
+    int q = ((move.direction % 4) + 4) % 4;
+
+    if (tables.faceIdx[idx] != -1) return tables.moves[tables.faceIdx[idx]][q];
+
+    throw std::invalid_argument("Unsupported move: " + move.to_string());
+}
+
+uint32_t rcube::PackedState::getMovedSlots(const rcube::Move &move)
+{
+    const MoveTables &tables = getTables();
+    int idx = ((int)move.face & 0x7f);
+    int q = ((move.direction % 4) + 4) % 4;
+
+    // an unsupported move does not change any slot
+    if (tables.faceIdx[idx] == -1) return 0;
+    return tables.movedSlots[tables.faceIdx[idx]][q];
+}
+
+bool rcube::PackedState::isSolved() const
+{
+    // solved means being one of the 24 rotations of the solved cube
+    const MoveTables &tables = getTables();
+    int idx = tables.rotationIdx[data[CENTERS + 3] - 8][data[CENTERS + 5] - 8];
+
+    return idx != -1 && *this == tables.rotations[idx];
+}
+
+bool rcube::PackedState::operator==(const rcube::PackedState &t) const
+{
+    return std::memcmp(data, t.data, 32) == 0;
+}
+
+bool rcube::PackedState::operator!=(const rcube::PackedState &t) const
+{
+    return !(*this == t);
+}
+
+uint64_t rcube::PackedState::getHash() const
+{
+    // the unused bytes never change, so they are left out
+    return getHash(0x3fff0fff);
+}
+
+uint64_t rcube::PackedState::getHash(uint32_t slots) const
+{
+    const MoveTables &tables = getTables();
+    uint64_t hash = 0;
+
+    while (slots)
+    {
+        int i = __builtin_ctz(slots);
+        hash ^= tables.zobrist[i][data[i] & 0x3f];
+        slots &= slots - 1;
+    }
+    return hash;
+}
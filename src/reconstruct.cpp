@@ -112,4 +112,6 @@ rcube::Cube::Cube(const std::map<rcube::Orientation, rcube::MixedFace> &data)
     {
         throw std::invalid_argument("Invalid input: the cube in not solvable");
     }
+
+    packBlocks();
 }
\ No newline at end of file
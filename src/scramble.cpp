@@ -0,0 +1,122 @@
+/*
+* Copyright (c) 2023 Lorenzo Pucci
+* You may use, distribute and modify this code under the terms of the MIT
+* license.
+*
+* You should have received a copy of the MIT license along with this program. If
+* not, see: <https://mit-license.org>.
+*/
+
+#include <random>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include <rcube.hpp>
+#include <solving.hpp>
+#include "./kociemba/cubieCube.hpp"
+#include "./kociemba/lookupTables.hpp"
+
+// every thread has its own generator, so that no locking is needed
+static std::mt19937_64& getGenerator()
+{
+    thread_local std::mt19937_64 generator(std::random_device{}() ^
+        std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return generator;
+}
+
+void rcube::Algorithm::seedScrambles(uint64_t seed)
+{
+    getGenerator().seed(seed);
+}
+
+rcube::Algorithm rcube::Algorithm::generateScramble(const int &length)
+{
+    std::mt19937_64 &generator = getGenerator();
+    std::uniform_int_distribution<int> randomFace(0, 5);
+    std::uniform_int_distribution<int> randomDir(0, 2);
+
+    MoveFace moves[6] = {RIGHT, LEFT, UP, DOWN, FRONT, BACK};
+    int prev = -1;
+
+    rcube::Algorithm scramble;
+    scramble.reserve(length);
+
+    while (scramble.length() < length)
+    {
+        int move = randomFace(generator);
+        if (move == prev) continue;
+
+        int dir = randomDir(generator); // {0, 1, 2}
+        if (dir == 0) dir = -1; // {-1, 1, 2}
+
+        scramble.push(rcube::Move(moves[move], static_cast<MoveDirection>(dir)));
+        prev = move;
+    }
+    return scramble;
+}
+
+static Kociemba::CubieCube randomState(std::mt19937_64 &generator)
+{
+    // any permutation and orientation of the pieces can be reached, as long
+    // as the permutations of the corners and of the edges have the same parity
+    // (the orientations are already valid by construction of flip and twist)
+
+    Kociemba::CubieCube cc;
+    cc.setCorners(std::uniform_int_distribution<int>(0, 40319)(generator));
+    cc.setTwist(std::uniform_int_distribution<int>(0, 2186)(generator));
+    cc.setFlip(std::uniform_int_distribution<int>(0, 2047)(generator));
+    std::shuffle(cc.ePerm, cc.ePerm + 12, generator);
+
+    if (cc.getCornerParity() != cc.getEdgeParity())
+        std::swap(cc.ePerm[0], cc.ePerm[1]);
+
+    return cc;
+}
+
+static rcube::Algorithm scrambleTo(const Kociemba::CubieCube &cc)
+{
+    rcube::Cube cube;
+    cube.performAlgorithm(cc.getPackedState());
+
+    KociembaSolver solver(cube);
+    solver.setVerbose(false);
+
+    // the solution takes the state to a solved cube, the scramble does the
+    // opposite
+    return solver.solve().reverse();
+}
+
+rcube::Algorithm rcube::Algorithm::generateRandomStateScramble()
+{
+    Kociemba::initTables();
+    return scrambleTo(randomState(getGenerator()));
+}
+
+std::vector<rcube::Algorithm> rcube::Algorithm::generateRandomStateScrambles(
+    int count, int threads)
+{
+    Kociemba::initTables();
+
+    // the states are picked by the calling thread, so that they only depend
+    // on its generator
+    std::vector<Kociemba::CubieCube> states;
+    states.reserve(count);
+    for (int i = 0; i < count; ++i) states.push_back(randomState(getGenerator()));
+
+    std::vector<rcube::Algorithm> scrambles(count);
+    if (threads < 1) threads = 1;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&states, &scrambles, t, threads]() {
+            for (int i = t; i < (int)states.size(); i += threads)
+                scrambles[i] = scrambleTo(states[i]);
+        });
+    }
+
+    for (std::thread &worker : workers) worker.join();
+    return scrambles;
+}
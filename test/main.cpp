@@ -8,10 +8,39 @@
 */
 
 #include <rcube.hpp>
+#include <solving.hpp>
 #include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "../src/kociemba/cubieCube.hpp"
+#include "../src/cfop/lastLayer.hpp"
 
 using namespace rcube;
 
+// The C++ tests cover the parts of the library that the Lua API does not
+// reach. They are run before test/main.lua, which needs Lua (LUA=true).
+
+bool passed = true;
+
+void test(const std::string &name, bool ok)
+{
+  std::cout << name << " ... " << (ok ? "\033[32m[OK]\033[00m" :
+    "\033[31m[FAILED]\033[00m") << std::endl;
+  passed = passed && ok;
+}
+
+Cube cubeFrom(const std::string &algo)
+{
+  Cube cube;
+  cube.performAlgorithm(algo);
+  return cube;
+}
+
 void printBlocks(const rcube::BlockArray& blocks)
 {
   for (int i = 0; i < 26; ++i)
@@ -30,9 +59,380 @@ void printBlocks(const rcube::BlockArray& blocks)
   }
 }
 
+void testHashing()
+{
+  std::cout << "\n~~~ Hashing ~~~" << std::endl;
+
+  Cube solved;
+  Cube r4 = cubeFrom("RRRR");
+  test("Hash: R4", r4 == solved && r4.getHash() == solved.getHash());
+
+  Cube sexy6;
+  for (int i = 0; i < 6; ++i) sexy6.performAlgorithm("RUR'U'");
+  test("Hash: (RUR'U')6", sexy6 == solved &&
+    std::hash<Cube>()(sexy6) == std::hash<Cube>()(solved));
+
+  Cube a = cubeFrom("R2U'F"), b = cubeFrom("RRU'F");
+  test("Hash: different algorithms", a == b && a.getHash() == b.getHash());
+  test("Hash: different states", a != solved &&
+    a.getHash() != solved.getHash());
+
+  // the hash is updated at each move, it must match the one of the state
+  bool matches = true;
+  Cube cube;
+  for (const char *algo : {"RUR'U'", "M2E'S", "rUl'd", "xy'z2", "F2B'D"})
+  {
+    cube.performAlgorithm(algo);
+    matches = matches && cube.getHash() == cube.getState().getHash();
+  }
+  test("Hash: incremental", matches);
+}
+
+void testSymmetries()
+{
+  std::cout << "\n~~~ Symmetries ~~~" << std::endl;
+
+  const std::string scramble = "RUR'U'F2D'L";
+  Cube cube = cubeFrom(scramble);
+  uint64_t key = cube.getSymmetryKey().key;
+
+  // the same scramble seen from the left and from the back
+  Cube rotated;
+  rotated.performAlgorithm(Algorithm("y" + scramble + "y'").withoutRotations());
+  test("Symmetry key: rotation", rotated.getSymmetryKey().key == key);
+  test("Symmetry key: whole cube rotations",
+    cubeFrom("y2" + scramble).getSymmetryKey().key == key);
+
+  // R and L swapped, with all the directions reversed
+  test("Symmetry key: mirror",
+    cubeFrom("L'U'LUF2DR'").getSymmetryKey().key == key);
+
+  test("Symmetry key: inverse", cubeFrom(Algorithm(scramble).reverse()
+    .to_string()).getSymmetryKey(true).key == cube.getSymmetryKey(true).key);
+  test("Symmetry key: different cubes",
+    cubeFrom("RUR'U'F2D'L'").getSymmetryKey().key != key);
+
+  // A solution of the representative is the solution of the cube (or of its
+  // inverse) conjugated by one of the symmetries: the ones that solve it are
+  // looked for among all of them, then mapped back
+  Algorithm solution = Algorithm(scramble).reverse();
+  for (bool useInverse : {false, true})
+  {
+    SymmetryKey sk = cube.getSymmetryKey(useInverse);
+    bool found = false, solves = true;
+
+    for (int sym = 0; sym < 48; ++sym)
+    {
+      for (const Algorithm &algo : {solution, solution.reverse()})
+      {
+        SymmetryKey probe = sk;
+        probe.symmetry = sym;
+        probe.inverse = false;
+        Algorithm repSolution = probe.mapSolution(algo);
+
+        PackedState state = sk.state;
+        state.multiply(repSolution.compile());
+        if (!state.isSolved()) continue;
+
+        Cube c = cube;
+        c.performAlgorithm(sk.mapSolution(repSolution));
+        found = true;
+        solves = solves && c.isSolved();
+      }
+    }
+    test(useInverse ? "Map solution: with inverse" : "Map solution",
+      found && solves);
+  }
+}
+
+void testCubeBatch()
+{
+  std::cout << "\n~~~ Cube batch ~~~" << std::endl;
+
+  // random cubes, plus one that the algorithm solves and a solved one
+  const Algorithm algo("RUR'U'M2F'd");
+  Algorithm::seedScrambles(1);
+
+  std::vector<Cube> cubes;
+  for (int i = 0; i < 70; ++i)
+    cubes.push_back(cubeFrom(Algorithm::generateScramble(20).to_string()));
+  cubes.push_back(cubeFrom(algo.reverse().to_string()));
+  cubes.push_back(Cube());
+
+  CubeBatch batch;
+  for (const Cube &cube : cubes) batch.push(cube);
+
+  batch.performAlgorithm(algo);
+  for (Cube &cube : cubes) cube.performAlgorithm(algo);
+
+  std::vector<bool> solved = batch.isSolved();
+  std::vector<uint16_t> twist = batch.getTwist(), flip = batch.getFlip(),
+    slice = batch.getSlice();
+
+  bool sameSolved = true, sameTwist = true, sameFlip = true, sameSlice = true;
+  int count = 0;
+  for (int i = 0; i < (int)cubes.size(); ++i)
+  {
+    // the batch reads the coordinates in the fixed frame of the slots
+    Kociemba::CubieCube cc(cubes[i].getState());
+    count += cubes[i].isSolved();
+    sameSolved = sameSolved && solved[i] == cubes[i].isSolved();
+    sameTwist = sameTwist && twist[i] == cc.getTwist();
+    sameFlip = sameFlip && flip[i] == cc.getFlip();
+    sameSlice = sameSlice && slice[i] == cc.getSliceSorted() / 24;
+  }
+
+  test("Batch: isSolved", sameSolved && solved[70]);
+  test("Batch: countSolved", batch.countSolved() == count);
+  test("Batch: twist", sameTwist);
+  test("Batch: flip", sameFlip);
+  test("Batch: slice", sameSlice);
+  test("Batch: get", batch.get(3) == cubes[3].getState());
+}
+
+void testCompile()
+{
+  std::cout << "\n~~~ Compiled algorithms ~~~" << std::endl;
+
+  bool same = true;
+  for (const char *str : {"", "RUR'U'", "M2E'S", "rUl'd2fb'", "xRy'Fz2",
+    "RUR'U'M2F'dx'B2L'D"})
+  {
+    Algorithm algo(str);
+    PackedState compiled = algo.compile();
+
+    PackedState state;
+    for (const Move &move : algo.algorithm) state.performMove(move);
+
+    Cube cube;
+    cube.performAlgorithm(compiled);
+    same = same && compiled == state && cube == cubeFrom(str) &&
+      cube.getHash() == cubeFrom(str).getHash();
+  }
+  test("Compile: same as the moves", same);
+
+  // compiling two algorithms and multiplying the results is the same as
+  // compiling their concatenation
+  PackedState product = Algorithm("RUR'").compile();
+  product.multiply(Algorithm("M2y").compile());
+  test("Compile: multiply", product == Algorithm("RUR'M2y").compile());
+
+  test("Order: RUR'U'", Algorithm("RUR'U'").getOrder() == 6);
+  test("Order: R", Algorithm("R").getOrder() == 4);
+  test("Order: RU", Algorithm("RU").getOrder() == 105);
+  test("Order: empty", Algorithm().getOrder() == 1);
+}
+
+// Returns the position returned by Algorithm::parse, and the number of moves
+// parsed before it in length
+int parsed(const std::string &str, int *length)
+{
+  MoveVector moves;
+  int pos = Algorithm::parse(str, &moves);
+  *length = moves.size();
+  return pos;
+}
+
+// Returns the message of the exception thrown by the Algorithm constructor
+std::string parseError(const std::string &str)
+{
+  try
+  {
+    Algorithm algo(str);
+  }
+  catch (const std::invalid_argument &e)
+  {
+    return e.what();
+  }
+  return "";
+}
+
+void testParser()
+{
+  std::cout << "\n~~~ Algorithm parser ~~~" << std::endl;
+
+  int length;
+  test("Parse: valid", parsed("R U2 (R' U') [x]", &length) == -1 &&
+    length == 5);
+  test("Parse: invalid character", parsed("RU?R", &length) == 2 &&
+    length == 2);
+  test("Parse: two directions", parsed("RUR'2", &length) == 4 &&
+    length == 3);
+  test("Parse: unknown macro", parsed("RU$(nope)R", &length) == 2 &&
+    length == 2);
+  test("Parse: unclosed macro", parsed("R$(sune", &length) == 1);
+  test("Parse: '$' without macro", parsed("R$U", &length) == 1);
+
+  Algorithm tPerm("(RUR'U')(R'FR2U')R'U'(RUR'F')");
+  test("Macro: followed by moves", Algorithm("$(T-perm)bU") == tPerm +
+    Algorithm("bU"));
+  test("Macro: between moves", Algorithm("R2$(sune)U'") ==
+    Algorithm("R2RUR'URU2R'U'"));
+  test("Macro: one after the other", Algorithm("$(sune)$(T-perm)") ==
+    Algorithm("RUR'URU2R'") + tPerm);
+
+  test("Parse error: position", parseError("RU?R") ==
+    "Invalid algorithm: unexpected '?' at position 2");
+  test("Parse error: unknown macro", parseError("R$(nope)") ==
+    "Cannot find algorithm: nope");
+}
+
+void testScrambles()
+{
+  std::cout << "\n~~~ Scrambles ~~~" << std::endl;
+
+  Algorithm::seedScrambles(42);
+  Algorithm first = Algorithm::generateScramble(25);
+  Algorithm::seedScrambles(42);
+  Algorithm second = Algorithm::generateScramble(25);
+  Algorithm::seedScrambles(43);
+  Algorithm other = Algorithm::generateScramble(25);
+
+  test("Scramble: same seed", first == second);
+  test("Scramble: different seed", first != other);
+  test("Scramble: length", first.length() == 25 &&
+    Algorithm::generateScramble(7).length() == 7);
+
+  bool sameFace = false;
+  for (int i = 1; i < first.length(); ++i)
+  {
+    sameFace = sameFace ||
+      first.algorithm[i].face == first.algorithm[i - 1].face;
+  }
+  test("Scramble: no consecutive moves of a face", !sameFace);
+
+  // the scrambled state has to be one that CFOP can solve
+  Cube cube = cubeFrom(first.to_string());
+  bool scrambled = !cube.isSolved();
+  cube.solveCfop();
+  test("Scramble: solvable", scrambled && cube.isSolved());
+}
+
+void testOptimizer()
+{
+  std::cout << "\n~~~ Optimizer ~~~" << std::endl;
+
+  // 7 moves that cannot be normalized, but can be done in 5
+  Algorithm algo("F'U2R'F'UFU2");
+  Algorithm optimized = algo.optimized();
+  test("Optimize: shorter", optimized.length() == 5);
+  test("Optimize: same state", optimized.compile() == algo.compile());
+
+  algo.optimize();
+  test("Optimize: in place", algo == optimized);
+
+  bool same = true, longer = false;
+  Algorithm::seedScrambles(7);
+  for (int i = 0; i < 20; ++i)
+  {
+    Algorithm scramble = Algorithm::generateScramble(30) +
+      Algorithm("RLR'L'U2D2");
+    Algorithm res = scramble.optimized(2);
+    same = same && res.compile() == scramble.compile();
+    longer = longer || res.length() > scramble.length();
+  }
+  test("Optimize: scrambles keep their state", same);
+  test("Optimize: scrambles never get longer", !longer);
+}
+
+void testLastLayerTable()
+{
+  std::cout << "\n~~~ Last layer table ~~~" << std::endl;
+
+  std::string path = (std::filesystem::temp_directory_path() /
+    "rcube_test.rcll").string();
+
+  // a table with a single record, the Sune case
+  Algorithm sune("RUR'URU2R'");
+  int key = getLastLayerKey(cubeFrom(sune.reverse().to_string()).getState());
+  writeLastLayerTable(path, {{key, sune}});
+
+  std::ifstream file(path, std::ios::binary);
+  std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)),
+    std::istreambuf_iterator<char>());
+  file.close();
+
+  bool littleEndian = bytes.size() == 4 + 4 + 4 + 1 + 7;
+  for (int i = 0; littleEndian && i < 4; ++i)
+  {
+    littleEndian = bytes[4 + i] == (i == 0) &&
+      bytes[8 + i] == ((key >> (8 * i)) & 0xff);
+  }
+  test("Last layer table: little-endian file", key >= 0 && littleEndian);
+  test("Last layer table: load", CfopSolver::loadLastLayerTable(path));
+
+  // the same case with U turns before and after it
+  Cube cube = cubeFrom("U" + sune.reverse().to_string() + "U2");
+  Algorithm algo;
+  bool found = getLastLayerAlgorithm(cube.getState(), &algo);
+  cube.performAlgorithm(algo);
+  test("Last layer table: round trip", found && cube.isSolved());
+
+  Cube tperm = cubeFrom("RUR'U'R'FR2U'R'U'RUR'F'");
+  test("Last layer table: missing case",
+    !getLastLayerAlgorithm(tperm.getState(), &algo));
+
+  // an empty table leaves the last layer to OLL and PLL again
+  writeLastLayerTable(path, {});
+  bool reset = CfopSolver::loadLastLayerTable(path);
+  cube = cubeFrom(sune.reverse().to_string());
+  test("Last layer table: reset", reset &&
+    !getLastLayerAlgorithm(cube.getState(), &algo));
+  std::filesystem::remove(path);
+}
+
+void testZbls()
+{
+  std::cout << "\n~~~ ZBLS ~~~" << std::endl;
+
+  // with ZBLS, the last F2L pair also orients the edges of the last layer
+  bool oriented = true, unorientedWithout = false;
+  Algorithm::seedScrambles(11);
+  for (int i = 0; i < 10; ++i)
+  {
+    Cube cube = cubeFrom(Algorithm::generateScramble(25).to_string());
+
+    for (bool zbls : {true, false})
+    {
+      CfopSolver solver(cube);
+      solver.useZbls(zbls);
+      Algorithm cross = solver.cross();
+      Algorithm f2l = solver.f2l();
+      Cube copy = cube;
+      copy.performAlgorithm(cross + f2l);
+
+      // the cross is on the bottom face, so the flip is measured along the
+      // axis of the last layer
+      Kociemba::CubieCube cc(copy.getState().getReoriented());
+      if (zbls) oriented = oriented && cc.getFlip() == 0;
+      else unorientedWithout = unorientedWithout || cc.getFlip() != 0;
+    }
+  }
+  test("ZBLS: last layer edges oriented after F2L", oriented);
+  test("ZBLS: not oriented without it", unorientedWithout);
+}
+
 int main()
 {
+  testHashing();
+  testSymmetries();
+  testCubeBatch();
+  testCompile();
+  testParser();
+  testScrambles();
+  testOptimizer();
+  testLastLayerTable();
+  testZbls();
+
+#ifndef IGNORE_LUA
   Cube cube = Cube();
 
+  // twice, to check that the first run leaves nothing behind
+  cube.runScript("test/main.lua");
   cube.runScript("test/main.lua");
+#endif
+
+  std::cout << (passed ? "\nAll C++ tests passed" : "\nErrors found in the "
+    "C++ tests") << std::endl;
+  return passed ? 0 : 1;
 }
@@ -42,6 +42,14 @@ end
 io.write("Is solved ... ")
 test(isSolved(), true)
 
+-- test/main.cpp runs this script twice: the changes made at its end must not
+-- be visible in the second run
+io.write("Globals reset ... ")
+test(leakedGlobal, nil)
+
+io.write("Library tables reset ... ")
+test(string.leaked == nil and math.pi > 3, true)
+
 
 print("\n~~~ Performing M2E2S2 ~~~")
 performAlgorithm("M2E2S2")
@@ -123,16 +131,39 @@ performAlgorithm("R'U'M2")
 io.write("Perform algorithm ... ")
 test(isSolved(), true)
 
+io.write("Solve: CFOP ... ")
+performAlgorithm("FRU'L2B'DR2F'UB2L'D2")
+solveCfop()
+test(isSolved(), true)
+
 print("\n~~~ Algorithm operations ~~~")
 
 io.write("Normalize: 1 ... ")
-test(normalizeAlgo("RLUUUy"), "RLU'y")
+test(normalizeAlgo("RLUUUy"), "RLd'")
 
 io.write("Normalize: 2 ... ")
 test(normalizeAlgo("RFF'BD2DD"), "RB")
 
 io.write("Normalize: 3 ... ")
-test(normalizeAlgo("BB'BBFRR2"), "B2FR'")
+test(normalizeAlgo("BB'BBFRR2"), "FB2R'")
+
+io.write("Normalize: commuting moves ... ")
+test(normalizeAlgo("RLR'"), "L")
+
+io.write("Normalize: cancelling groups ... ")
+test(normalizeAlgo("RUU'R'"), "")
+
+io.write("Normalize: wide moves ... ")
+test(normalizeAlgo("RM'L'"), "L'r")
+
+io.write("Normalize: slice moves ... ")
+test(normalizeAlgo("RL'x'"), "M")
+
+io.write("Normalize: wide and slice moves ... ")
+test(normalizeAlgo("RrM'"), "r2")
+
+io.write("Normalize: rotations ... ")
+test(normalizeAlgo("UD'yUD"), "U'd'")
 
 io.write("Reverse: 1 ... ")
 test(reverseAlgo("R2URUR'U'R'U'R'UR'"), "RU'RURURU'R'U'R2")
@@ -146,6 +177,73 @@ test(removeRotations("RyRF'"), "RBR'")
 io.write("Remove rotations: 2 ... ")
 test(removeRotations("x2UR'y'LDzF2R"), "DR'FUL2D")
 
+io.write("Remove rotations: wide moves ... ")
+test(removeRotations("rUr'"), "LFL'")
+
+io.write("Remove rotations: cancelling rotations ... ")
+test(removeRotations("yRy'y2Fy2"), "B2")
+
+print("\n~~~ Cube and Algorithm types ~~~")
+
+local sexy = Algorithm("RUR'U'")
+
+io.write("Algorithm: concatenation ... ")
+test(tostring(sexy .. "F"), "RUR'U'F")
+
+io.write("Algorithm: reverse ... ")
+test(-sexy == Algorithm("URU'R'"), true)
+
+io.write("Cube: apply ... ")
+test((Cube() * sexy * -sexy):isSolved(), true)
+
+io.write("Cube: comparison ... ")
+test(Cube(sexy) == Cube():performMove("R", 1):performAlgorithm("UR'U'"), true)
+
+io.write("Cube: order ... ")
+local cube = Cube()
+for i = 1, 6 do cube:performAlgorithm(sexy) end
+test(cube:isSolved(), true)
+
+io.write("Async solve ... ")
+local scrambled = Cube("RUR'U'F2DB")
+local solution
+spawn(function() solution = scrambled:solveCfopAsync() end)
+runTasks()
+test((scrambled * solution):isSolved(), true)
+
+io.write("Errors: unknown move ... ")
+test(pcall(performMove, "Q", 1) or pcall(Cube().performMove, Cube(), "Q", 1),
+    false)
+
+io.write("Errors: exceptions ... ")
+test(pcall(find, "kq"), false)
+
+print("\n~~~ Bulk functions ~~~")
+
+io.write("Get facelets ... ")
+test(Cube():getFacelets(), string.rep("o", 9) .. string.rep("r", 9) ..
+    string.rep("y", 9) .. string.rep("w", 9) .. string.rep("b", 9) ..
+    string.rep("g", 9))
+
+io.write("Face matches any ... ")
+test(faceMatchesAny({axis=1, direction=1}, {"YYYYYYYYY", "WWWWWWWWW"}), 2)
+
+io.write("Perform algorithms ... ")
+local cubes = {Cube(), Cube("R"), Cube("U")}
+performAlgorithms(cubes, {"U", "R'", "U'"})
+test(cubes[1] == Cube("U") and cubes[2]:isSolved() and cubes[3]:isSolved(),
+    true)
+
+io.write("Solve cubes ... ")
+performAlgorithms(cubes, "RUR'U'F")
+local solutions = solveCubes(cubes)
+test((cubes[1] * solutions[1]):isSolved() and
+    (cubes[3] * solutions[3]):isSolved(), true)
+
+leakedGlobal = true
+string.leaked = true
+math.pi = 0
+
 if passed then
     print("\nAll tests passed")
 else